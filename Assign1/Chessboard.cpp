@@ -46,7 +46,7 @@ const char *pixelShader = "\
 
 void Display() {
 	// called whenever application displayed
-	glUseProgram(programId);
+	GLSL::UseProgram(programId);
 	GLSL::VertexAttribPointer(programId, "point", 2, GL_FLOAT, GL_FALSE, 0,
 		(void *)0);
 	glDrawArrays(GL_QUADS, 0, 4);	// display entire window
@@ -57,7 +57,7 @@ void InitVertexBuffer() {
 	float pts[][2] = { { -1,-1 },{ -1,1 },{ 1,1 },{ 1,-1 } };
 	// create GPU buffer for 4 verts, bind, allocate/copy
 	glGenBuffers(1, &vBufferId);
-	glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(pts), pts, GL_STATIC_DRAW);
 }
 
@@ -65,7 +65,7 @@ void InitVertexBuffer() {
 void Reshape(int w, int h) {
 	// called by GLUT whenever application is resized
 	// adjust checkerboard to window size by setting 'uResolution'
-	glUseProgram(programId);
+	GLSL::UseProgram(programId);
 	int uniform_WindowSize = glGetUniformLocation(programId, "uResolution");
 	glUniform2f(uniform_WindowSize, (float)w, (float)h);
 }
@@ -81,7 +81,7 @@ void main(int argc, char **argv) {	// application entry
 	/*
 	// adjust checkerboard to initialized window size by setting 'uResolution'
 	int uniform_WindowSize = glGetUniformLocation(programId, "uResolution");
-	glUseProgram(programId);
+	GLSL::UseProgram(programId);
 	glUniform2f(uniform_WindowSize, glutGet(GLUT_WINDOW_WIDTH),
 		glutGet(GLUT_WINDOW_HEIGHT));
 	float width = glutGet(GLUT_WINDOW_WIDTH);
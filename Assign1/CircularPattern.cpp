@@ -77,7 +77,7 @@ const char *pixelShader = "\
 
 void Display() {
 	// called whenever application displayed
-	glUseProgram(programId);
+	GLSL::UseProgram(programId);
 	GLSL::VertexAttribPointer(programId, "point", 2, GL_FLOAT, GL_FALSE, 0,
 		(void *)0);
 	glDrawArrays(GL_QUADS, 0, 4);	// display entire window
@@ -88,7 +88,7 @@ void InitVertexBuffer() {
 	float pts[][2] = { { -1,-1 },{ -1,1 },{ 1,1 },{ 1,-1 } };
 	// create GPU buffer for 4 verts, bind, allocate/copy
 	glGenBuffers(1, &vBufferId);
-	glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(pts), pts, GL_STATIC_DRAW);
 }
 
@@ -102,7 +102,7 @@ void main(int argc, char **argv) {	// application entry
 
 	// adjust checkerboard to initialized window size by setting 'uResolution'
 	int uniform_WindowSize = glGetUniformLocation(programId, "uResolution");
-	glUseProgram(programId);
+	GLSL::UseProgram(programId);
 	glUniform2f(uniform_WindowSize, glutGet(GLUT_WINDOW_WIDTH),
 		glutGet(GLUT_WINDOW_HEIGHT));
 	float width = glutGet(GLUT_WINDOW_WIDTH);
@@ -15,6 +15,7 @@ vector<int3> triangles;
 vector<vec3> points;
 vector<vec3> normals;
 vector<vec2> uvs;
+MeshLoader	 loader;					// reads mesh while window is responsive
 
 // colors
 vec3	 blk(0), wht(1), cyan(0,1,1);
@@ -30,12 +31,16 @@ void   *picked = NULL, *hover = NULL;
 // movable light
 vec3	lightSource(-.2f, .4f, .8f);
 Mover	lightMover(&lightSource);
+VisibilityQuery lightQuery;								// is light unoccluded? answered a frame later
 
 // sliders
 Slider	scl(30, 20, 70, -1, 1, 0, true, "scl", &wht);			// height scale
 
 // shader indices
-GLuint	shaderId = 0, vBufferId = 0, textureId = 0;				// valid if > 0
+GLuint	shaderId = 0, vBufferId = 0;							// valid if > 0
+
+// height map, streamed
+TextureStreamer heightfield;
 
 // vertex shader
 char *vShaderCode = "\
@@ -136,17 +141,46 @@ char *pShaderCode = "\
 
 // Display
 
+void UploadObject();
+
+void DisplayProgress() {
+	// progress bar while mesh loads
+	int width = glutGet(GLUT_WINDOW_WIDTH), height = glutGet(GLUT_WINDOW_HEIGHT), w = width-100;
+	UseDrawShader(ScreenMode());
+	GLSL::Disable(GL_DEPTH_TEST);
+	Rectangle(50, height/2-10, w, 20, wht, false);
+	Rectangle(50, height/2-10, (int) (w*loader.Progress()), 20, wht);
+	Text(50, height/2+20, blk, "loading (Esc to cancel)");
+}
+
+void LightTimer(int value) {
+	// redisplay if the light's visibility, answered after the frame was drawn, has changed
+	if (lightQuery.Changed())
+		glutPostRedisplay();
+	else if (lightQuery.Pending())
+		glutTimerFunc(10, LightTimer, 0);
+}
+
 void Display() {
     // background, blending, zbuffer
     glClearColor(.6f, .6f, .6f, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND);
-    glEnable(GL_POINT_SMOOTH);
-    glEnable(GL_LINE_SMOOTH);
+    GLSL::Enable(GL_BLEND);
+    GLSL::Enable(GL_POINT_SMOOTH);
+    GLSL::Enable(GL_LINE_SMOOTH);
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
+    GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLSL::Enable(GL_DEPTH_TEST);
     glClear(GL_DEPTH_BUFFER_BIT);
+	MeshLoader::State state = loader.Poll();
+	if (state == MeshLoader::Loading)
+		DisplayProgress();
+	if (state == MeshLoader::Loaded && !vBufferId)
+		UploadObject();
+	if (!vBufferId) {
+		glFlush();
+		return;
+	}
 	// compute transformation matrices
 	modelview = Translate(0, 0, dolly)*RotateY(rotNew.x)*RotateX(rotNew.y);
 	float fov = 15, nearPlane = -.001f, farPlane = -500;
@@ -155,12 +189,15 @@ void Display() {
 	fullview = persp*modelview;
 	screen = ScreenMode();
 	// use tessellation shader
-	glUseProgram(shaderId);
+	GLSL::UseProgram(shaderId);
 	GLSL::SetUniform(shaderId, "useTexture", USE_TEXTURE);	// sets whether to use texture (USE_TEXTURE = true) or
 															// set color based on displacement on height (false)
 	// set uniforms for height map and texture map
+	heightfield.Poll();
+	GLSL::ActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, heightfield.Texture());
 	GLSL::SetUniform(shaderId, "heightScale", scl.GetValue());
-	GLSL::SetUniform(shaderId, "heightField", (int) textureId);
+	GLSL::SetUniform(shaderId, "heightField", 1);		// texture unit
 	// GLSL::SetUniform(shaderId, "textureImage", 0);	// replace white with texture
 	// update matrices
 	GLSL::SetUniform(shaderId, "modelview", modelview);
@@ -170,7 +207,7 @@ void Display() {
 	vec3 xlight(hLight.x, hLight.y, hLight.z);
 	glUniform3fv(glGetUniformLocation(shaderId, "light"), 1, (float *) &xlight);
     // activate vertex buffer and establish shader links
-    glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	int sizePts = points.size()*sizeof(vec3);
 	GLSL::VertexAttribPointer(shaderId, "point",  3,  GL_FLOAT, GL_FALSE, 0, (void *) 0);
 	GLSL::VertexAttribPointer(shaderId, "normal", 3,  GL_FLOAT, GL_FALSE, 0, (void *) sizePts);
@@ -183,9 +220,11 @@ void Display() {
 	glDrawElements(GL_PATCHES, 3*triangles.size(), GL_UNSIGNED_INT, &triangles[0]);
 	// draw sliders, light in 2D screen space
 	UseDrawShader(screen);
-	if (IsVisible(lightSource, fullview))
+	lightQuery.Submit(1, &lightSource, fullview);
+	glutTimerFunc(10, LightTimer, 0);
+	if (lightQuery.Visible(0))
 		Sun(ScreenPoint(lightSource, fullview), hover == &lightSource? &cyan : NULL);
-	glDisable(GL_DEPTH_TEST);
+	GLSL::Disable(GL_DEPTH_TEST);
 	scl.Draw();
     glFlush();
 }
@@ -193,11 +232,16 @@ void Display() {
 // Input
 
 void ReadObject(char *filename) {
-	// read Alias/Wavefront "obj" formatted mesh file
-	if (!ReadAsciiObj(filename, points, triangles, &normals, &uvs)) {
-		printf("Failed to read %s\n", filename);
-		return;
-	}
+	// start reading Alias/Wavefront "obj" formatted mesh file; Display uploads it when loaded
+	loader.Start(filename, true, true);
+}
+
+void UploadObject() {
+	// take loaded mesh from loader and send to GPU (on the GL thread)
+	points.swap(loader.points);
+	normals.swap(loader.normals);
+	uvs.swap(loader.textures);
+	triangles.swap(loader.triangles);
 	// scale/move model to uniform +/-1
 	int npoints = points.size();
 	int sizepts = npoints*sizeof(vec3), sizenrms = sizepts, sizeuvs = npoints*sizeof(vec2);
@@ -205,13 +249,34 @@ void ReadObject(char *filename) {
 	Normalize(points, .8f);
     // create GPU buffer, make it active, fill
     glGenBuffers(1, &vBufferId);
-    glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	glBufferData(GL_ARRAY_BUFFER, sizepts+sizenrms+sizeuvs, 0, GL_STATIC_DRAW);
 	glBufferSubData(GL_ARRAY_BUFFER, 0, sizepts, &points[0]);
 	glBufferSubData(GL_ARRAY_BUFFER, sizepts, sizenrms, &normals[0]);
 	glBufferSubData(GL_ARRAY_BUFFER, sizepts+sizenrms, sizeuvs, &uvs[0]);
 }
 
+void LoadTimer(int value) {
+	// redisplay progress until mesh is loaded and height map is resident
+	MeshLoader::State state = loader.Poll();
+	TextureStreamer::State mapState = heightfield.Poll();
+	if (state == MeshLoader::Loading || mapState == TextureStreamer::Decoding || mapState == TextureStreamer::Uploading)
+		glutTimerFunc(100, LoadTimer, 0);
+	else {
+		if (state == MeshLoader::Failed)
+			printf("Failed to read mesh\n");
+		if (mapState == TextureStreamer::Failed)
+			printf("Failed to read height map\n");
+	}
+	glutPostRedisplay();
+}
+
+void Keyboard(unsigned char key, int x, int y) {
+	if (key == 27)		// escape
+		loader.Cancel();
+	glutPostRedisplay();
+}
+
 // Interactive Rotation
 
 void MouseOver(int x, int y) {
@@ -267,27 +332,16 @@ void MouseWheel(int wheel, int direction, int x, int y) {
 // Application
 
 void Close() {
+	loader.Cancel();
 	// unbind vertex buffer, free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBufferId);
-	glDeleteBuffers(1, &textureId);
+	lightQuery.Release();
+	heightfield.Release();
 }
 
 int MakeShaderProgram() {
-	int vShader = GLSL::CompileShaderViaCode(vShaderCode, GL_VERTEX_SHADER);
-	int pShader = GLSL::CompileShaderViaCode(pShaderCode, GL_FRAGMENT_SHADER);
-	int teShader = GLSL::CompileShaderViaCode(teShaderCode, GL_TESS_EVALUATION_SHADER);
-	int program = vShader && pShader && teShader? glCreateProgram() : 0, status;
-	if (vShader && pShader && teShader) {
-        glAttachShader(program, vShader);
-        glAttachShader(program, pShader);
-		glAttachShader(program, teShader);
-        glLinkProgram(program);
-        glGetProgramiv(program, GL_LINK_STATUS, &status);
-        if (status == GL_FALSE)
-            GLSL::PrintProgramLog(program);
-	}
-	return program;
+	return GLSL::LinkProgramViaCode(vShaderCode, NULL, teShaderCode, NULL, pShaderCode);
 }
 
 int Error(char *msg) {
@@ -302,13 +356,14 @@ int main(int argc, char **argv) {
     glutInitWindowSize(500, 500);
     glutCreateWindow("Shader Example");
     glewInit();
-	// build, use shaderId program
+	// build, use shaderId program (reloaded after the first run)
+	GLSL::SetProgramCache(".");
 	if (!(shaderId = MakeShaderProgram()))
 		return Error("Can't link shader program\n");
-	// read object and height map
+	// read object and height map (optionally named on the command line: a 16-bit .pgm
+	// or float .pfm/.r32 displaces without the terracing of an 8-bit .tga)
 	ReadObject("C:\\Users\\amgrieco\\Dropbox\\Graphics\\Checkerboard2\\Chair.obj");
-	textureId = SetHeightfield("C:\\Users\\amgrieco\\Dropbox\\Graphics\\Checkerboard2\\metalcurves.tga");
-	if (!triangles.size() || !textureId)
+	if (!heightfield.Start(argc > 1? argv[1] : "C:\\Users\\amgrieco\\Dropbox\\Graphics\\Checkerboard2\\metalcurves.tga", true))
 		return Error("Can't open file(s)\n");
 	GLSL::SetUniform(shaderId, "textureImage", 0);	// replace white with texture
 	// GLUT callbacks, event loop
@@ -317,6 +372,8 @@ int main(int argc, char **argv) {
 	glutMotionFunc(MouseDrag);
 	glutMouseWheelFunc(MouseWheel);
 	glutPassiveMotionFunc(MouseOver);
+	glutKeyboardFunc(Keyboard);
+	glutTimerFunc(100, LoadTimer, 0);
     glutCloseFunc(Close);
     glutMainLoop();
 	return 0;
@@ -26,6 +26,7 @@ void   *picked = NULL, *hover = NULL;
 // movable light
 vec3	lightSource(-.2f, .4f, .8f);
 Mover	lightMover(&lightSource);
+VisibilityQuery lightQuery;								// is light unoccluded? answered a frame later
 
 // sliders
 Slider	scl(30, 20, 70, -1, 1, 0, true, "scl", &wht);	// height scale
@@ -116,16 +117,24 @@ char *pShaderCode = "\
 
 // Display
 
+void LightTimer(int value) {
+	// redisplay if the light's visibility, answered after the frame was drawn, has changed
+	if (lightQuery.Changed())
+		glutPostRedisplay();
+	else if (lightQuery.Pending())
+		glutTimerFunc(10, LightTimer, 0);
+}
+
 void Display() {
     // background, blending, zbuffer
     glClearColor(.6f, .6f, .6f, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND);
-    glEnable(GL_POINT_SMOOTH);
-    glEnable(GL_LINE_SMOOTH);
+    GLSL::Enable(GL_BLEND);
+    GLSL::Enable(GL_POINT_SMOOTH);
+    GLSL::Enable(GL_LINE_SMOOTH);
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
+    GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLSL::Enable(GL_DEPTH_TEST);
     glClear(GL_DEPTH_BUFFER_BIT);
 	// compute transformation matrices
 	mat4 rotM = RotateY(rotNew.x)*RotateX(rotNew.y);
@@ -137,11 +146,11 @@ void Display() {
 	fullview = persp*modelview;
 	screen = ScreenMode();
 	// use tessellation shader
-	glUseProgram(shaderId);
+	GLSL::UseProgram(shaderId);
 	// set uniforms for height map and texture map
 	GLSL::SetUniform(shaderId, "heightScale", scl.GetValue());
-	GLSL::SetUniform(shaderId, "heightField", (int) textureIds[1]);
-	GLSL::SetUniform(shaderId, "textureImage", (int) textureIds[0]);
+	GLSL::SetUniform(shaderId, "heightField", 2);		// texture units
+	GLSL::SetUniform(shaderId, "textureImage", 1);
 	// update matrices
 	GLSL::SetUniform(shaderId, "modelview", modelview);
 	GLSL::SetUniform(shaderId, "persp", persp);
@@ -150,7 +159,7 @@ void Display() {
 	vec3 xlight(hLight.x, hLight.y, hLight.z);
 	glUniform3fv(glGetUniformLocation(shaderId, "light"), 1, (float *) &xlight);
     // activate vertex buffer and establish shader links
-    glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	GLSL::VertexAttribPointer(shaderId, "point",  3,  GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) 0);
 	GLSL::VertexAttribPointer(shaderId, "normal", 3,  GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) sizeof(vec3));
 	GLSL::VertexAttribPointer(shaderId, "uv",     2,  GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (2*sizeof(vec3)));
@@ -163,65 +172,40 @@ void Display() {
 	glDrawArrays(GL_PATCHES, 0, vertices.size());
 	// draw sliders, light in 2D screen space
 	UseDrawShader(screen);
-	if (IsVisible(lightSource, fullview))
+	lightQuery.Submit(1, &lightSource, fullview);
+	glutTimerFunc(10, LightTimer, 0);
+	if (lightQuery.Visible(0))
 		Sun(ScreenPoint(lightSource, fullview), hover == &lightSource? &cyan : NULL);
-	glDisable(GL_DEPTH_TEST);
+	GLSL::Disable(GL_DEPTH_TEST);
 	scl.Draw();
     glFlush();
 }
 
 // Texture and Height Maps
 
-char *ReadTarga(string filename, int &width, int &height) {
-	// open targa file, read header, return pointer to pixels
-	FILE *in = fopen(filename.c_str(), "rb");
-	if (in) {
-		short tgaHeader[9];
-		fread(tgaHeader, sizeof(tgaHeader), 1, in);
-		// allocate, read pixels
-		int w = width = tgaHeader[6], h = height = tgaHeader[7];
-		int bitsPerPixel = tgaHeader[8], bytesPerPixel = bitsPerPixel/8, bytesPerImage = w*h*bytesPerPixel;
-		if (bytesPerPixel != 3) {
-			printf("bytes per pixel not 3!\n");
-			return NULL;
-		}
-		char *pixels = new char[bytesPerImage];
-		fread(pixels, bytesPerImage, 1, in);
-		return pixels;
-	}
-	printf("can't open %s\n", filename);
-	return NULL;
-}
-
 void SetTexture(string filename) {
-	// open targa file, read header, store as textureIds[0]
-	int width, height;
-	char *pixels = ReadTarga(filename.c_str(), width, height);
-	// set and bind active texture corresponding with textureIds[0]
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, textureIds[0]);	// 1
-	// allocate GPU texture buffer; copy, free pixels
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);			// accommodate width not multiple of 4
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, pixels);
-	delete [] pixels;
-	glGenerateMipmap(GL_TEXTURE_2D);
+	// store as textureIds[0], shared with any other use of the same image
+	GLSL::ActiveTexture(GL_TEXTURE1);
+	textureIds[0] = AcquireTexture(filename.c_str());
 }
 
 void SetHeightfield(string filename) {
 	// open targa file, read header, store as GL_TEXTURE2
-	int width, height;
-	char *pixels = ReadTarga(filename.c_str(), width, height);
-	// convert to luminance
-	for (int i = 0; i < width*height; i++) {
-		char *p = pixels+3*i;
-		p[0] = p[1] = p[2] = (int) (.21*(double)p[2]+.72*(double)p[1]+.07*(double)p[0]);
-	}
+	int width, height, bitsPerPixel, bytesPerPixel;
+	char *pixels = ReadTexture(filename.c_str(), width, height, bitsPerPixel);
+	if (!pixels)
+		return;
+	// convert to luminance, in place
+	if ((bytesPerPixel = bitsPerPixel/8) >= 3)
+		BGRToLuminance((unsigned char *) pixels, width*height, bytesPerPixel, (unsigned char *) pixels);
 	// set and bind active texture corresponding with textureIds[1]
-	glActiveTexture(GL_TEXTURE2);
+	GLSL::ActiveTexture(GL_TEXTURE2);
 	glBindTexture(GL_TEXTURE_2D, textureIds[1]); // 2
 	// allocate GPU texture buffer; copy, free pixels
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // in case width not multiple of 4
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, pixels);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+	GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_ONE};		// shader reads height from any of r, g, b
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
 	delete [] pixels;
 	glGenerateMipmap(GL_TEXTURE_2D);
 }
@@ -246,7 +230,7 @@ void ReadObject(char *filename) {
 		vertices[i].point = points[i];
     // create GPU buffer, make it active, fill
     glGenBuffers(1, &vBufferId);
-    glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 }
 
@@ -306,26 +290,15 @@ void MouseWheel(int wheel, int direction, int x, int y) {
 
 void Close() {
 	// unbind vertex buffer, free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBufferId);
-	glDeleteBuffers(2, textureIds);
+	lightQuery.Release();
+	ReleaseTexture(textureIds[0]);
+	glDeleteTextures(1, &textureIds[1]);
 }
 
 int MakeShaderProgram() {
-	int vShader = GLSL::CompileShaderViaCode(vShaderCode, GL_VERTEX_SHADER);
-	int pShader = GLSL::CompileShaderViaCode(pShaderCode, GL_FRAGMENT_SHADER);
-	int teShader = GLSL::CompileShaderViaCode(teShaderCode, GL_TESS_EVALUATION_SHADER);
-	int program = vShader && pShader && teShader? glCreateProgram() : 0, status;
-	if (vShader && pShader && teShader) {
-        glAttachShader(program, vShader);
-        glAttachShader(program, pShader);
-		glAttachShader(program, teShader);
-        glLinkProgram(program);
-        glGetProgramiv(program, GL_LINK_STATUS, &status);
-        if (status == GL_FALSE)
-            GLSL::PrintProgramLog(program);
-	}
-	return program;
+	return GLSL::LinkProgramViaCode(vShaderCode, NULL, teShaderCode, NULL, pShaderCode);
 }
 
 void main(int argc, char **argv) {
@@ -334,7 +307,8 @@ void main(int argc, char **argv) {
     glutInitWindowSize(800, 800);
     glutCreateWindow("Shader Example");
     glewInit();
-	// build, use shaderId program
+	// build, use shaderId program (reloaded after the first run)
+	GLSL::SetProgramCache(".");
 	if (!(shaderId = MakeShaderProgram())) {
 		printf("Can't link shader program\n");
 		getchar();
@@ -342,7 +316,7 @@ void main(int argc, char **argv) {
 	}
 	ReadObject("C:\\Users\\amgrieco\\Dropbox\\Graphics\\Checkerboard2\\teacup.obj");
 	// init texture and height maps
-	glGenTextures(2, textureIds);
+	glGenTextures(1, &textureIds[1]);
 	SetTexture("C:\\Users\\amgrieco\\Dropbox\\Graphics\\Checkerboard2\\turquoise.tga");
 	SetHeightfield("C:\\Users\\amgrieco\\Dropbox\\Graphics\\Checkerboard2\\heightmap.tga");
 	// GLUT callbacks, event loop
@@ -55,7 +55,7 @@ void InitVertexBuffer() {
 		}
     // create GPU buffer, make it active, allocate memory and copy vertices
     glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 }
 
@@ -63,7 +63,7 @@ void Display() {
 	// clear screen to grey
     glClearColor(.5f, .5f, .5f, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
     // establish vertex fetch for point and for color
 	GLSL::VertexAttribPointer(program, "vPoint", 2,  GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) 0);
 	GLSL::VertexAttribPointer(program, "vColor", 3,  GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) sizeof(vec2));
@@ -74,7 +74,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer and free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	if (vBuffer >= 0)
 		glDeleteBuffers(1, &vBuffer);
 }
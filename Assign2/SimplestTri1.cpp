@@ -34,7 +34,7 @@ char *fragmentShader = "\
 void InitVertexBuffer() {
     // create a vertex buffer for the array, and make it the active vertex buffer
     glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);	// to be a vertex array buffer
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);	// to be a vertex array buffer
     // allocate buffer memory to hold vertex locations and colors
     glBufferData(GL_ARRAY_BUFFER, sizeof(points)+sizeof(colors), NULL, GL_STATIC_DRAW);
     // load data to the GPU
@@ -57,7 +57,7 @@ void InitShader() {
 void Display() {
     glClearColor(.5, .5, .5, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(program);
+    GLSL::UseProgram(program);
     // associate position input to shader with position array in vertex buffer 
     GLuint vPosition = glGetAttribLocation(program, "vPosition");
     glEnableVertexAttribArray(vPosition);
@@ -72,7 +72,7 @@ void Display() {
 }
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
@@ -107,7 +107,7 @@ void InitVertexBuffer() {
 //	triangles = getTriangles();
 	// create a vertex buffer for the array, and make it the active vertex buffer
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);	// to be a vertex array buffer
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);	// to be a vertex array buffer
 	// allocate buffer memory to hold vertex locations and colors
 	glBufferData(GL_ARRAY_BUFFER, sizeof(triangles) + sizeof(colors), NULL, GL_STATIC_DRAW);
 	// load data to the GPU
@@ -130,7 +130,7 @@ void InitShader() {
 void Display() {
 	glClearColor(.1, .1, .1, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 	// associate position input to shader with position array in vertex buffer 
 	GLuint vPosition = glGetAttribLocation(program, "vPosition");
 	glEnableVertexAttribArray(vPosition);
@@ -145,7 +145,7 @@ void Display() {
 }
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
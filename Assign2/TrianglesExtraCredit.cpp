@@ -80,7 +80,7 @@ void InitVertexBuffer() {
 		}
 	}
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);	// to be a vertex array buffer
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);	// to be a vertex array buffer
 	/* Note: see changes here compared to simpleTri version using two arrays */
 	glBufferData(GL_ARRAY_BUFFER, nverts * sizeof(Vertex), &vertices[0],
 		GL_STATIC_DRAW);
@@ -104,7 +104,7 @@ void Display() {
 	glClearColor(.1, .1, .1, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
 
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 	// associate position input to shader with position array in vertex buffer 
 	GLuint vPosition = glGetAttribLocation(program, "vPosition");
 	glEnableVertexAttribArray(vPosition);
@@ -121,7 +121,7 @@ void Display() {
 		glDrawArrays(GL_TRIANGLES, 3 * i, 3);
 	}
 
-	glUseProgram(programGreen);
+	GLSL::UseProgram(programGreen);
 	for (int i = 1; i < ntriangles; i += 2)
 	{
 		glDrawArrays(GL_TRIANGLES, 3 * i, 3);
@@ -131,7 +131,7 @@ void Display() {
 }
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
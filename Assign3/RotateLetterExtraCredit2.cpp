@@ -79,7 +79,7 @@ void InitVertexBuffer() {
 		}
 	}
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	glBufferData(GL_ARRAY_BUFFER, nverts * sizeof(Vertex), &vertices[0],
 		GL_STATIC_DRAW);
 }
@@ -97,7 +97,7 @@ void InitShader() {
 void Display() {
 	glClearColor(.1, .1, .1, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 	// establish vertex fetch for point and for coor
 	GLSL::VertexAttribPointer(program, "vPosition", 2, GL_FLOAT, GL_FALSE,
 		sizeof(Vertex), (void *)0);
@@ -111,7 +111,7 @@ void Display() {
 }
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	if (vBuffer >= 0) {
 		glDeleteBuffers(1, &vBuffer);
 	}
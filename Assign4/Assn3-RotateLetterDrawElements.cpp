@@ -54,7 +54,7 @@ char *pixelShader = "\
 void InitVertexBuffer() {
     // create GPU buffer to hold positions and colors, and make it the active buffer
     glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
     // allocate memory for vertex positions and colors
     glBufferData(GL_ARRAY_BUFFER, sizeof(points)+sizeof(colors), NULL, GL_STATIC_DRAW);
     // load data to sub-buffers
@@ -78,7 +78,7 @@ void Idle() {
 void Display() {
     glClearColor(.5, .5, .5, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(program);
+    GLSL::UseProgram(program);
     // set vertex feed for points and colors, then draw
     GLSL::VertexAttribPointer(program, "point", 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
     GLSL::VertexAttribPointer(program, "color", 3, GL_FLOAT, GL_FALSE, 0, (void *) sizeof(points));
@@ -90,7 +90,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer and free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
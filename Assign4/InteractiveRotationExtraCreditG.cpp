@@ -117,7 +117,7 @@ void InitVertexBuffer() {
 	}
 	// create and bind GPU vertex buffer, copy vertex data
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	glBufferData(GL_ARRAY_BUFFER, nverts * sizeof(Vertex), &vertices[0],
 		GL_STATIC_DRAW);
 }
@@ -151,7 +151,7 @@ void MouseDrag(int x, int y)
 void Display() {
 	glClearColor(.1, .1, .1, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 
 	// update angle
 	mat4 view = RotateY(rotNew.x) * RotateX(rotNew.y);
@@ -162,9 +162,9 @@ void Display() {
 	GLSL::VertexAttribPointer(program, "vColor", 3, GL_FLOAT, GL_FALSE,
 		sizeof(Vertex), (void *) sizeof(vec3));
 
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// draw triangles
 	glDrawArrays(GL_TRIANGLES, 0, vertices.size());
 	glFlush();
@@ -172,7 +172,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer and free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	if (vBuffer >= 0) {
 		glDeleteBuffers(1, &vBuffer);
 	}
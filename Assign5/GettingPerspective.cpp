@@ -70,7 +70,7 @@ void InitVertexBuffer() {
 	}
 	// create and bind GPU vertex buffer, copy vertex data
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
 		&vertices[0], GL_STATIC_DRAW);
 }
@@ -129,12 +129,12 @@ void Display() {
 	glClearColor(0.1, 0.1, 0.1, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
 	// enable z-buffer (needed for tetrahedron)
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// update view transformation
-	glUseProgram(program);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);	// needed bc. UseDrawShader changes
+	GLSL::UseProgram(program);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);	// needed bc. UseDrawShader changes
 											// vertex buffer binding
 	mat4 modelView = Translate(tranNew.x, tranNew.y, 0) * RotateY(rotNew.x) *
 		RotateX(rotNew.y);	// based on user's translate & rotate
@@ -154,7 +154,7 @@ void Display() {
 	// draw triangles
 	glDrawArrays(GL_TRIANGLES, 0, vertices.size());
 	// draw controls in 2d screen space
-	glDisable(GL_DEPTH_TEST);
+	GLSL::Disable(GL_DEPTH_TEST);
 	mat4 screen = Translate(-1, -1, 0) * Scale(2 / width, 2 / height, 1);
 	UseDrawShader(screen);	// Draw.h
 	fov.Draw();				// Widget.h
@@ -163,7 +163,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer, free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
@@ -82,7 +82,7 @@ void InitVertexBuffer() {
 	}
     // create and bind GPU vertex buffer, copy vertex data
     glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 }
 
@@ -122,12 +122,12 @@ void Display() {
     glClearColor(.5, .5, .5, 1);
     glClear(GL_COLOR_BUFFER_BIT);
 	// enable z-buffer (needed for tetrahedron)
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// update view transformation
-    glUseProgram(program);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    GLSL::UseProgram(program);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	mat4 view = Translate(tranNew)*RotateY(rotNew.x)*RotateX(rotNew.y);
 	mat4 dolly = Translate(0, 0, -1);
 	mat4 proj = Ortho(-1, 1, -1, 1, 0, 10);
@@ -143,7 +143,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer, free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
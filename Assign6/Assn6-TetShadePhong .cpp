@@ -134,7 +134,7 @@ void InitVertexBuffer() {
 	}
     // create and bind GPU vertex buffer, copy vertex data
     glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 }
 
@@ -173,12 +173,12 @@ void Display() {
 	// clear screen to grey, enable z-buffer
     glClearColor(.5, .5, .5, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// update view transformation
-    glUseProgram(program);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    GLSL::UseProgram(program);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	mat4 view = Translate(tranNew)*RotateY(rotNew.x)*RotateX(rotNew.y);
 #ifdef PERSP
 	float width = (float) glutGet(GLUT_WINDOW_WIDTH), height = (float) glutGet(GLUT_WINDOW_HEIGHT);
@@ -199,7 +199,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer, free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
@@ -58,7 +58,7 @@ char *pixelShader = "\
 void InitVertexBuffer() {
 	// create GPU buffer, make it the active buffer
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	// allocate memory for vertex positions and normals
 	int points_size = points.size() * sizeof(vec3);
 	int normals_size = normals.size() * sizeof(vec3);
@@ -91,7 +91,7 @@ void MouseDrag(int x, int y) {
 void Display() {
 	static float fov = 15, nearPlane = -.001f, farPlane = -500;
 	static float aspect = (float)glutGet(GLUT_WINDOW_WIDTH) / (float)glutGet(GLUT_WINDOW_HEIGHT);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 	// update and send matrices to vertex shader
 	mat4 view = Translate(0, 0, -5)*RotateY(rotNew.x)*RotateX(rotNew.y);
 	mat4 persp = Perspective(fov, aspect, nearPlane, farPlane);
@@ -103,11 +103,11 @@ void Display() {
 	// clear screen to grey, enable transparency, use z-buffer
 	glClearColor(.3f, .3f, .3f, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_BLEND);
+	GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// link shader inputs with  vertex buffer
 	int points_size = points.size() * sizeof(vec3);
 	/* setup vertex feeder */
@@ -129,7 +129,7 @@ void GetObjectFromFile() {
 }
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
@@ -72,7 +72,7 @@ void MouseDrag(int x, int y) {
 void Display() {
 	static float fov = 15, nearPlane = -.001f, farPlane = -500;
 	static float aspect = (float)glutGet(GLUT_WINDOW_WIDTH) / (float)glutGet(GLUT_WINDOW_HEIGHT);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 	// update and send matrices to vertex shader
 	mat4 view = Translate(0, 0, -10)*RotateY(rotNew.x)*RotateX(rotNew.y);
 	mat4 persp = Perspective(fov, aspect, nearPlane, farPlane);
@@ -84,11 +84,11 @@ void Display() {
 	// clear screen to grey, enable transparency, use z-buffer
 	glClearColor(0, .2f, 0, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_BLEND);
+	GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// link shader inputs with vertex buffer
 	/* setup vertex feeder */
 	GLSL::VertexAttribPointer(program, "point", 3, GL_FLOAT, GL_FALSE, sizeof(VertexSTL), (void *) 0);
@@ -110,13 +110,13 @@ void GetVerticesFromFile() {
 
 void InitVertexBuffer() {
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	/* send vertex data to GPU */
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexSTL), &vertices[0], GL_STATIC_DRAW);
 }
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
@@ -66,7 +66,7 @@ char *pixelShader = "\
 void InitVertexBuffer() {
     // create GPU buffer, make it the active buffer
     glGenBuffers(1, &vBufferId);
-    glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	// allocate and fill vertex buffer
 	int nPts = points.size(), nNrms = normals.size(), nTex = textures.size();
 	int sizePts = nPts*sizeof(vec3), sizeNrms = nNrms*sizeof(vec3), sizeTex = nTex*sizeof(vec2);
@@ -123,8 +123,8 @@ void MouseDrag(int x, int y) {
 
 void Display() {
 	// activate shader, vertex buffer
-    glUseProgram(programId);
-    glBindBuffer(GL_ARRAY_BUFFER, vBufferId);
+    GLSL::UseProgram(programId);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, vBufferId);
 	// update and send matrices to vertex shader
 	mat4 view = Translate(0, 0, -5)*RotateY(rotNew.x)*RotateX(rotNew.y);
 	GLSL::SetUniform(programId, "view", view);
@@ -138,11 +138,11 @@ void Display() {
 	// clear screen, enable transparency, use z-buffer
     glClearColor(.5f, .5f, .5f, 1);
     glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_DEPTH_BUFFER);
+    GLSL::Enable(GL_BLEND);
+    GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
     // establish shader links
 	int sizePts = points.size()*sizeof(vec3);
 	GLSL::VertexAttribPointer(programId, "point", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
@@ -157,7 +157,7 @@ void Display() {
 
 void Close() {
 	// unbind vertex buffer, free GPU memory
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBufferId);
 }
 
@@ -75,7 +75,7 @@ char *pixelShader = "\
 void InitVertexBuffer() {
 	// create GPU buffer, make it the active buffer
 	glGenBuffers(1, &vBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, vBuffer);
 	// allocate memory for vertex positions and normals
 	int sizePts = points.size() * sizeof(vec3);
 	int sizeNrms = normals.size() * sizeof(vec3);
@@ -115,7 +115,7 @@ static float degPerSec = 30;
 // Application
 
 void Display() {
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 	// use for rotation of uv coordinates
 	float dt = (float)(clock() - startTime) / CLOCKS_PER_SEC;
 	GLSL::SetUniform(program, "radAng", (3.1415f/180.f)*dt*degPerSec);
@@ -133,11 +133,11 @@ void Display() {
 	// clear screen to grey, enable transparency, use z-buffer
 	glClearColor(.5f, .5f, .5f, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_DEPTH_BUFFER);
+	GLSL::Enable(GL_BLEND);
+	GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLSL::Enable(GL_DEPTH_BUFFER);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_DEPTH_TEST);
+	GLSL::Enable(GL_DEPTH_TEST);
 	// setup vertex feeder
 	int sizePts = points.size() * sizeof(vec3);
 	int sizeNrms = normals.size() * sizeof(vec3);
@@ -170,7 +170,7 @@ void InitTexture(const char *filename) {
 
 
 void Close() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &vBuffer);
 }
 
@@ -68,12 +68,12 @@ void *font = GLUT_BITMAP_9_BY_15;
 void PutString(int x, int y, const char *text, vec3 &color) {
 	int program = GLSL::CurrentShader();
 	int w = glutGet(GLUT_WINDOW_WIDTH), h = glutGet(GLUT_WINDOW_HEIGHT);
-	glUseProgram(0); // no text support in GLSL
+	GLSL::UseProgram(0); // no text support in GLSL
 	float xf = (float) (2*x)/w-1, yf = (float) (2*y)/h-1;
 	glColor3fv(&color.x);
 	glRasterPos2f(xf, yf);
 	glutBitmapString(font, (unsigned char*) text);
-	glUseProgram(program);
+	GLSL::UseProgram(program);
 }
 
 int Text(int x, int y, vec3 &color, char *format, ...) {
@@ -154,7 +154,7 @@ vec3 blk(0), wht(1), offWht(.95f), ltGry(.9f), mdGry(.6f), dkGry(.4f);
 void CheckDrawBuffer() {
 	if (!drawBuffer) {
 		glGenBuffers(1, &drawBuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+		GLSL::BindBuffer(GL_ARRAY_BUFFER, drawBuffer);
 		glBufferData(GL_ARRAY_BUFFER, 4*sizeof(vec3), NULL, GL_STATIC_DRAW);
 	}
 }
@@ -163,12 +163,11 @@ int UseDrawShader() {
 	int current = GLSL::CurrentShader();
 	if (!drawShader)
 		drawShader = InitShader(vertexShader, pixelShader);
-	if (current != drawShader)
-		glUseProgram(drawShader);
-	glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_LINE_SMOOTH);
-	glEnable(GL_POINT_SMOOTH);
+	GLSL::UseProgram(drawShader);
+	GLSL::Enable(GL_BLEND);
+    GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLSL::Enable(GL_LINE_SMOOTH);
+	GLSL::Enable(GL_POINT_SMOOTH);
 	return current;
 }
 
@@ -179,19 +178,19 @@ int UseDrawShader(mat4 viewMatrix) {
 }
 
 bool DashOn() {
-	GLboolean on = glIsEnabled(GL_LINE_STIPPLE);
-	glEnable(GL_LINE_STIPPLE);
+	bool on = GLSL::IsEnabled(GL_LINE_STIPPLE);
+	GLSL::Enable(GL_LINE_STIPPLE);
     glLineStipple(1, 3855); // on 4 bits / off 4 bits / on 4 bits / off 4 bits
-	return on != 0;
+	return on;
 }
 
-void DashOff() { glDisable(GL_LINE_STIPPLE); }
+void DashOff() { GLSL::Disable(GL_LINE_STIPPLE); }
 
 // Disk
 
 void Disk(vec3 &point, float diameter, vec3 &color, float opacity) {
 	CheckDrawBuffer();
-	glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, drawBuffer);
 	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vec3), &point.x);
 	GLSL::VertexAttribPointer(drawShader, "point", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
 	GLSL::SetUniform(drawShader, "opacity", opacity);
@@ -205,23 +204,22 @@ void Disk(vec3 &point, float diameter, vec3 &color, float opacity) {
 void Line(vec3 &p1, vec3 &p2, vec3 &color, float opacity, float width, bool dashed) {
 	bool was = dashed? DashOn() : false;
 	dashed? DashOn() : void();
-	float w;
-	glGetFloatv(GL_LINE_WIDTH, &w);
-	glLineWidth(width);
+	float w = GLSL::LineWidth();
+	GLSL::LineWidth(width);
 	int current = UseDrawShader();
 	CheckDrawBuffer();
-    glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, drawBuffer);
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vec3), &p1.x);
     glBufferSubData(GL_ARRAY_BUFFER, sizeof(vec3), sizeof(vec3), &p2.x);
 	GLSL::VertexAttribPointer(drawShader, "point", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
 	GLSL::SetUniform(drawShader, "color", color);
 	GLSL::SetUniform(drawShader, "opacity", opacity);
 	glDrawArrays(GL_LINES, 0, 2);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glUseProgram(current);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::UseProgram(current);
 	if (!was && dashed)
 		DashOff();
-	glLineWidth(w);
+	GLSL::LineWidth(w);
 }
 
 void Line(int x1, int y1, int x2, int y2, vec3 &color, float opacity) {
@@ -234,14 +232,14 @@ void Quad(vec3 &p1, vec3 &p2, vec3 &p3, vec3 &p4, vec3 &color, float opacity) {
 	int current = UseDrawShader();
 	vec3 points[] = {p1, p2, p3, p4};
 	CheckDrawBuffer();
-    glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+    GLSL::BindBuffer(GL_ARRAY_BUFFER, drawBuffer);
     glBufferSubData(GL_ARRAY_BUFFER, 0, 4*sizeof(vec3), points);
 	GLSL::VertexAttribPointer(drawShader, "position", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
 	GLSL::SetUniform(drawShader, "color", opacity);
 	GLSL::SetUniform(drawShader, "opacity", opacity);
 	glDrawArrays(GL_QUADS, 0, 4);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glUseProgram(current);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::UseProgram(current);
 }
 
 void Rectangle(int x, int y, int w, int h, vec3 &color, bool solid, float opacity) {
@@ -369,10 +367,10 @@ void Button::Draw(char *nameOverride, vec3 *statusColor) {
 		winW = glutGet(GLUT_WINDOW_WIDTH);
 		winH = glutGet(GLUT_WINDOW_HEIGHT);
 	}
-	glDisable(GL_BLEND);
-	glDisable(GL_LINE_SMOOTH);
-	glDisable(GL_POINT_SMOOTH);
-	glDisable(GL_DEPTH_TEST);
+	GLSL::Disable(GL_BLEND);
+	GLSL::Disable(GL_LINE_SMOOTH);
+	GLSL::Disable(GL_POINT_SMOOTH);
+	GLSL::Disable(GL_DEPTH_TEST);
 	if (type == B_Rectangle) {
 		float c[] = {1,0,0};
 		Rectangle(x, y, w, h, offWht, true);
@@ -410,7 +408,7 @@ void Button::Draw(char *nameOverride, vec3 *statusColor) {
 
 void Button::Highlight() {
 	Rectangle(x, y, w, h, wht, true, .5f);
-	glLineWidth(1.f);
+	GLSL::LineWidth(1.f);
 	float x1 = (float)x, x2 = x1+(float)w, y1 = (float)y, y2 = y1+(float)h;
 	Line(vec3(x1+1, y1+1.5f, 0), vec3(x2-1, y1+1.5f, 0), blk, 1);
 	Line(vec3(x2-1.5f, y2-1, 0), vec3(x2-1.5f, y1+1, 0), blk, 1);
@@ -478,7 +476,7 @@ void Slider::SetRange(float min, float max, float init) {
 
 void Slider::Draw(char *nameOverride, vec3 *sliderColor) {
 	vec3 *sCol = sliderColor? sliderColor : &color;
-	glLineWidth(2);
+	GLSL::LineWidth(2);
 	int iloc = (int) loc;
 	float grays[] = {160, 105, 227, 255};
 	if (vertical) {
@@ -5,6 +5,7 @@
 #include "mat.h"
 #include <time.h>
 #include "UI.h"
+#include "GLSL.h"
 
 // Bezier class
 
@@ -135,12 +136,12 @@ void Display() {
 	// background, blending, zbuffer
 	glClearColor(.6f, .6f, .6f, 1);
 	glClear(GL_COLOR_BUFFER_BIT);
-	glEnable(GL_BLEND);
-	glEnable(GL_POINT_SMOOTH);
-	glEnable(GL_LINE_SMOOTH);
+	GLSL::Enable(GL_BLEND);
+	GLSL::Enable(GL_POINT_SMOOTH);
+	GLSL::Enable(GL_LINE_SMOOTH);
 	glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_DEPTH_TEST);
+	GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLSL::Disable(GL_DEPTH_TEST);
 	// update transformations, enable UI draw shader
 	mat4 ortho = Ortho(-1, 1, -1, 1, -.01f, -10);
 	view = ortho*Translate(0, 0, 1)*RotateY(rotNew.x)*RotateX(rotNew.y);
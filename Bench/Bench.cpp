@@ -0,0 +1,39 @@
+/*	==============================
+    Bench.cpp - run the MeshIO/GLSL benchmarks
+	usage: Bench [name ...]; with no names all benchmarks run
+	exit status is nonzero if any benchmark disagrees with its reference
+	=============================== */
+
+#include <stdio.h>
+#include <string.h>
+#include "Bench.h"
+
+struct Benchmark {
+	const char *name;
+	bool (*run)();
+};
+
+static Benchmark benchmarks[] = {
+	{"obj", ObjBench},
+	{"objthreads", ObjThreadsBench},
+	{"normals", NormalsBench},
+	{"pixels", PixelTest},
+	{"locations", LocationBench}
+};
+
+int main(int ac, char **av) {
+	int nBenchmarks = sizeof(benchmarks)/sizeof(Benchmark), nFailed = 0;
+	for (int i = 0; i < nBenchmarks; i++) {
+		bool selected = ac < 2;
+		for (int a = 1; a < ac; a++)
+			selected = selected || !strcmp(av[a], benchmarks[i].name);
+		if (!selected)
+			continue;
+		printf("%s:\n", benchmarks[i].name);
+		if (!benchmarks[i].run()) {
+			printf("%s: FAILED\n", benchmarks[i].name);
+			nFailed++;
+		}
+	}
+	return nFailed? 1 : 0;
+}
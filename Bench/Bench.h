@@ -0,0 +1,48 @@
+/*	==============================
+    Bench.h - timing support for the MeshIO/GLSL benchmarks
+	=============================== */
+
+#ifndef BENCH_HDR
+#define BENCH_HDR
+
+#include <chrono>
+
+inline double Seconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <class Task>
+double BestTime(Task task, int nRuns = 3) {
+	// return the fastest of nRuns calls to task, in seconds
+	double best = 0;
+	for (int i = 0; i < nRuns; i++) {
+		double start = Seconds();
+		task();
+		double t = Seconds()-start;
+		best = i == 0 || t < best? t : best;
+	}
+	return best;
+}
+
+inline double MBPerSecond(double bytes, double seconds) {
+	return seconds > 0? bytes/(1 << 20)/seconds : 0;
+}
+
+// each benchmark prints its timings and returns false if results disagree with the reference
+
+bool ObjBench();
+	// parse a generated OBJ with ReadAsciiObj and with the original fgets/sscanf reader
+
+bool ObjThreadsBench();
+	// parse a generated OBJ with 1, 2, 4, ... threads
+
+bool NormalsBench();
+	// compute vertex normals of a generated grid with SetVertexNormals and with the original loop
+
+bool PixelTest();
+	// check the pixel conversion kernels against scalar code over many sizes and inputs, and time them
+
+bool LocationBench();
+	// count and time the uniform and attribute lookups of repeated draws, against a GL stub
+
+#endif
@@ -0,0 +1,166 @@
+/*	==============================
+    LocationBench.cpp - uniform/attribute location cache, with a recording GL stub
+	=============================== */
+
+#include <stdio.h>
+#include <string.h>
+#include "GLSL.h"
+#include "Bench.h"
+
+// the stub stands in for a driver (no context is needed): one program with a few active
+// uniforms and attributes, found by hashing the name and searching; it counts lookups and
+// records the last value set at each location
+
+#ifdef _WIN32
+#define STUB __stdcall
+#else
+#define STUB
+#endif
+
+static const char *uniformNames[] = {"view", "persp", "color", "opacity", "useLight", "light", "fade", "textureMap"};
+static const char *attributeNames[] = {"position", "normal", "uv"};
+static const int nUniforms = sizeof(uniformNames)/sizeof(char *), nAttributes = sizeof(attributeNames)/sizeof(char *);
+static const GLuint program = 1;
+
+static int nUniformLookups = 0, nAttributeLookups = 0;
+static float uniformValues[nUniforms][16];
+static const void *attributePointers[nAttributes];
+
+static unsigned int Hash(const char *s) {
+	unsigned int h = 5381;
+	while (*s)
+		h = 33*h+*s++;
+	return h;
+}
+
+static GLint Lookup(const char **names, int n, const char *name) {
+	unsigned int h = Hash(name);
+	for (int i = 0; i < n; i++)
+		if (Hash(names[i]) == h && !strcmp(names[i], name))
+			return i;
+	return -1;
+}
+
+static void STUB GetProgramiv(GLuint, GLenum pname, GLint *v) {
+	*v = pname == GL_ACTIVE_UNIFORMS? nUniforms : pname == GL_ACTIVE_ATTRIBUTES? nAttributes : 32;
+}
+
+static void Active(const char *name, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *out) {
+	strncpy(out, name, bufSize);
+	*length = (GLsizei) strlen(name);
+	*size = 1;
+	*type = GL_FLOAT;
+}
+
+static void STUB GetActiveUniform(GLuint, GLuint i, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+	Active(uniformNames[i], bufSize, length, size, type, name);
+}
+
+static void STUB GetActiveAttrib(GLuint, GLuint i, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+	Active(attributeNames[i], bufSize, length, size, type, name);
+}
+
+static GLint STUB GetUniformLocation(GLuint, const GLchar *name) {
+	nUniformLookups++;
+	return Lookup(uniformNames, nUniforms, name);
+}
+
+static GLint STUB GetAttribLocation(GLuint, const GLchar *name) {
+	nAttributeLookups++;
+	return Lookup(attributeNames, nAttributes, name);
+}
+
+static void STUB Uniform1f(GLint l, GLfloat v) { uniformValues[l][0] = v; }
+static void STUB Uniform3f(GLint l, GLfloat x, GLfloat y, GLfloat z) { float *u = uniformValues[l]; u[0] = x; u[1] = y; u[2] = z; }
+static void STUB UniformMatrix4fv(GLint l, GLsizei, GLboolean, const GLfloat *m) { memcpy(uniformValues[l], m, 16*sizeof(float)); }
+static void STUB EnableVertexAttribArray(GLuint) { }
+static void STUB VertexAttribPointer(GLuint l, GLint, GLenum, GLboolean, GLsizei, const void *p) { attributePointers[l] = p; }
+
+static void InstallStub() {
+	__glewGetProgramiv = GetProgramiv;
+	__glewGetActiveUniform = GetActiveUniform;
+	__glewGetActiveAttrib = GetActiveAttrib;
+	__glewGetUniformLocation = GetUniformLocation;
+	__glewGetAttribLocation = GetAttribLocation;
+	__glewUniform1f = Uniform1f;
+	__glewUniform3f = Uniform3f;
+	__glewUniformMatrix4fv = UniformMatrix4fv;
+	__glewEnableVertexAttribArray = EnableVertexAttribArray;
+	__glewVertexAttribPointer = VertexAttribPointer;
+}
+
+// a Line()-style draw: view, color, opacity and position, three ways
+
+static void DrawLookingUp(int i, mat4 view) {
+	// as GLSL did before the cache: a driver lookup for every variable
+	GLint v = glGetUniformLocation(program, "view"), c = glGetUniformLocation(program, "color");
+	GLint o = glGetUniformLocation(program, "opacity"), p = glGetAttribLocation(program, "position");
+	glUniformMatrix4fv(v, 1, true, (float *) &view[0][0]);
+	glUniform3f(c, (float) i, 0, 1);
+	glUniform1f(o, .5f);
+	glEnableVertexAttribArray(p);
+	glVertexAttribPointer(p, 3, GL_FLOAT, GL_FALSE, 0, (void *) (size_t) i);
+}
+
+static void DrawByName(int i, mat4 view) {
+	GLSL::SetUniform(program, "view", view);
+	GLSL::SetUniform(program, "color", vec3((float) i, 0, 1));
+	GLSL::SetUniform(program, "opacity", .5f);
+	GLSL::VertexAttribPointer(program, "position", 3, GL_FLOAT, GL_FALSE, 0, (void *) (size_t) i);
+}
+
+static GLint viewId, colorId, opacityId, positionId;
+
+static void DrawByHandle(int i, mat4 view) {
+	GLSL::SetUniform(viewId, view);
+	GLSL::SetUniform(colorId, vec3((float) i, 0, 1));
+	GLSL::SetUniform(opacityId, .5f);
+	GLSL::VertexAttribPointer(positionId, 3, GL_FLOAT, GL_FALSE, 0, (void *) (size_t) i);
+}
+
+struct Recorded {
+	float values[nUniforms][16];
+	const void *pointers[nAttributes];
+};
+
+static Recorded Record() {
+	Recorded r;
+	memcpy(r.values, uniformValues, sizeof(uniformValues));
+	memcpy(r.pointers, attributePointers, sizeof(attributePointers));
+	return r;
+}
+
+bool LocationBench() {
+	const int nDraws = 100000;
+	InstallStub();
+	mat4 view = Translate(1, 2, 3);
+	const char *names[] = {"driver lookups", "name-based calls", "handles"};
+	void (*draws[])(int, mat4) = {DrawLookingUp, DrawByName, DrawByHandle};
+	Recorded first;
+	bool same = true;
+	for (int k = 0; k < 3; k++) {
+		GLSL::ForgetLocations(program);
+		nUniformLookups = nAttributeLookups = 0;
+		memset(uniformValues, 0, sizeof(uniformValues));
+		memset(attributePointers, 0, sizeof(attributePointers));
+		double start = Seconds();
+		if (draws[k] == DrawByHandle) {
+			viewId = GLSL::UniformLocation(program, "view");
+			colorId = GLSL::UniformLocation(program, "color");
+			opacityId = GLSL::UniformLocation(program, "opacity");
+			positionId = GLSL::AttributeLocation(program, "position");
+		}
+		for (int i = 0; i < nDraws; i++)
+			draws[k](i, view);
+		double t = Seconds()-start;
+		Recorded r = Record();
+		if (k == 0)
+			first = r;
+		bool sameValues = !memcmp(&r, &first, sizeof(Recorded));
+		same = same && sameValues;
+		printf("  %-17s %6d uniform + %6d attribute lookups, %5.1f ms%s\n",
+			   names[k], nUniformLookups, nAttributeLookups, 1000*t, sameValues? "" : ", VALUES DIFFER");
+	}
+	printf("  (%d draws; the stub's lookup is a hash and a short search, a driver's costs more)\n", nDraws);
+	return same;
+}
@@ -0,0 +1,83 @@
+/*	==============================
+    NormalsBench.cpp - SetVertexNormals against the original serial loop
+	=============================== */
+
+#include <stdio.h>
+#include <math.h>
+#include "MeshIO.h"
+#include "Bench.h"
+
+static void OriginalSetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals) {
+	// size normals array and initialize to zero
+	int nverts = (int) points.size();
+	normals.resize(nverts, vec3(0));
+	// accumulate each triangle normal into its three vertex normals
+	for (int i = 0; i < (int) triangles.size(); i++) {
+		int3 &t = triangles[i];
+		vec3 &p1 = points[t.i1], &p2 = points[t.i2], &p3 = points[t.i3];
+		vec3 a(p2-p1), b(p3-p2), n(normalize(cross(a, b)));
+		normals[t.i1] += n;
+		normals[t.i2] += n;
+		normals[t.i3] += n;
+	}
+	// set to unit length
+	for (int i = 0; i < nverts; i++)
+		normals[i] = normalize(normals[i]);
+}
+
+static void Grid(int n, vector<vec3> &points, vector<int3> &triangles) {
+	// n by n bumpy heightfield, two triangles per cell
+	points.resize(0);
+	triangles.resize(0);
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < n; i++) {
+			float x = (float) i/(n-1), y = (float) j/(n-1);
+			points.push_back(vec3(x, y, .1f*sin(6*x)*cos(6*y)));
+		}
+	for (int j = 0; j < n-1; j++)
+		for (int i = 0; i < n-1; i++) {
+			int a = j*n+i, b = a+1, c = b+n, d = a+n;
+			triangles.push_back(int3(a, b, c));
+			triangles.push_back(int3(a, c, d));
+		}
+}
+
+static float MaxDifference(const vector<vec3> &a, const vector<vec3> &b) {
+	if (a.size() != b.size())
+		return 1;
+	float max = 0;
+	for (int i = 0; i < (int) a.size(); i++) {
+		vec3 d(a[i]-b[i]);
+		float m = fabs(d.x) > fabs(d.y)? fabs(d.x) : fabs(d.y);
+		m = m > fabs(d.z)? m : fabs(d.z);
+		max = m > max? m : max;
+	}
+	return max;
+}
+
+bool NormalsBench() {
+	// summation order differs from the original (SSE blocks, per-thread buffers), so
+	// normals are compared to within a few float ulps rather than bit for bit
+	const float tolerance = 1e-5f;
+	vector<vec3> points, original, normals;
+	vector<int3> triangles;
+	Grid(1000, points, triangles);
+	double mTriangles = triangles.size()/1e6;
+	double tOriginal = BestTime([&]() {
+		original.resize(0);
+		OriginalSetVertexNormals(points, triangles, original);
+	});
+	printf("  %d vertices, %d triangles\n", (int) points.size(), (int) triangles.size());
+	printf("  original:       %6.1f ms (%.1f M triangles/s)\n", 1000*tOriginal, mTriangles/tOriginal);
+	bool same = true;
+	int maxThreads = std::thread::hardware_concurrency();
+	maxThreads = maxThreads > 4? maxThreads : 4;
+	for (int nThreads = 1; nThreads <= maxThreads; nThreads = nThreads < maxThreads && 2*nThreads > maxThreads? maxThreads : 2*nThreads) {
+		double t = BestTime([&]() { SetVertexNormals(points, triangles, normals, nThreads); });
+		float diff = MaxDifference(normals, original);
+		same = same && diff <= tolerance;
+		printf("  %2d threads:     %6.1f ms (%.1f M triangles/s, %.2fx), max difference %g%s\n",
+			   nThreads, 1000*t, mTriangles/t, tOriginal/t, diff, diff <= tolerance? "" : ", NORMALS DIFFER");
+	}
+	return same;
+}
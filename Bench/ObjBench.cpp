@@ -0,0 +1,311 @@
+/*	==============================
+    ObjBench.cpp - ReadAsciiObj against the original fgets/sscanf reader
+	=============================== */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include "MeshIO.h"
+#include "Bench.h"
+
+// the reader as it was before memory-mapping and tokenizing (vertex map, fgets, sscanf)
+
+static bool ReadWord(char* &ptr, char *word, int charLimit) {
+	ptr += strspn(ptr, " \t");					// skip white space
+	int nChars = strcspn(ptr, " \t");	        // get # non-white-space characters
+	if (!nChars)
+		return false;					        // no non-space characters
+	int nRead = charLimit-1 < nChars? charLimit-1 : nChars;
+	strncpy(word, ptr, nRead);
+	word[nRead] = 0;							// strncpy does not null terminate
+	ptr += nChars;
+		return true;
+}
+
+struct Compare {
+	bool operator() (const int3 &a, const int3 &b) const {
+		return (a.i1==b.i1? (a.i2==b.i2? a.i3 < b.i3 : a.i2 < b.i2) : a.i1 < b.i1);
+	}
+};
+
+typedef std::map<int3, int, Compare> VidMap;
+
+static bool OriginalReadAsciiObj(char          *filename,
+								 vector<vec3>	&points,
+								 vector<int3>	&triangles,
+								 vector<vec3>	*normals,
+								 vector<vec2>	*textures,
+								 vector<int>	*triangleGroups) {
+	FILE *in = fopen(filename, "r");
+	if (!in)
+		return false;
+	vec2 t;
+	vec3 v;
+	int group = 0;
+	static const int LineLim = 1000, WordLim = 100;
+	char line[LineLim], word[WordLim];
+	vector<vec3> tmpVertices, tmpNormals;
+	vector<vec2> tmpTextures;
+	VidMap vidMap;
+	for (int lineNum = 0;; lineNum++) {
+		if (feof(in))                              // hit end of file
+			break;
+		fgets(line, LineLim, in);                  // \ line continuation not supported
+		if (strlen(line) >= LineLim-1) {           // getline reads LineLim-1 max
+			printf("line %d too long", lineNum);
+			fclose(in);
+			return false;
+		}
+		char *ptr = line;
+		if (!ReadWord(ptr, word, WordLim))
+			continue;
+		else if (*word == '#')
+			continue;
+		else if (!_stricmp(word, "g"))
+			sscanf(ptr, "%d", &group);
+		else if (!_stricmp(word, "v")) {           // read vertex coordinates
+			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
+				printf("bad line %d in object file", lineNum);
+				fclose(in);
+				return false;
+			}
+			tmpVertices.push_back(vec3(v.x, v.y, v.z));
+		}
+		else if (!_stricmp(word, "vn")) {          // read vertex normal
+			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
+				printf("bad line %d in object file", lineNum);
+				fclose(in);
+				return false;
+			}
+			tmpNormals.push_back(vec3(v.x, v.y, v.z));
+		}
+		else if (!_stricmp(word, "vt")) {          // read vertex texture
+			if (sscanf(ptr, "%g%g", &t.x, &t.y) != 2) {
+				printf("bad line in object file");
+				fclose(in);
+				return false;
+			}
+			tmpTextures.push_back(vec2(t.x, t.y));
+		}
+		else if (!_stricmp(word, "f")) {           // read triangle or polygon
+			static vector<int> vids;
+			vids.resize(0);
+			while (ReadWord(ptr, word, WordLim)) { // read arbitrary # face vid/tid/nid
+				char *tPtr = strchr(word+1, '/');  // pointer to /, or null if not found
+				char *nPtr = tPtr? strchr(tPtr+1, '/') : NULL;
+				int vid = atoi(word);
+				if (!vid) // atoi returns 0 if failure to convert
+					break;
+				int tid = tPtr && *++tPtr != '/'? atoi(tPtr) : vid;
+				int nid = nPtr && *++nPtr != 0? atoi(nPtr) : vid;
+				vid--;
+				tid--;
+				nid--;
+				if (vid < 0 || tid < 0 || nid < 0) {
+					printf("bad format on line %d\n", lineNum);
+					break;
+				}
+				int3 key(vid, tid, nid);
+				VidMap::iterator it = vidMap.find(key);
+				if (it == vidMap.end()) {
+					int nvrts = points.size();
+					vidMap[key] = nvrts;
+					points.push_back(tmpVertices[vid]);
+					if (normals && (int) tmpNormals.size() > nid)
+						normals->push_back(tmpNormals[nid]);
+					if (textures && (int) tmpTextures.size() > tid)
+						textures->push_back(tmpTextures[tid]);
+					vids.push_back(nvrts);
+				}
+				else
+					vids.push_back(it->second);
+			}
+			int nids = vids.size();
+			if (nids == 3) {
+				int id1 = vids[0], id2 = vids[1], id3 = vids[2];
+				if (normals && (int) normals->size() > id1) {
+					vec3 &p1 = points[id1], &p2 = points[id2], &p3 = points[id3];
+					vec3 a(p2-p1), b(p3-p2), n(cross(a, b));
+					if (dot(n, (*normals)[id1]) < 0)
+						std::swap(id1, id3);
+				}
+				triangles.push_back(int3(id1, id2, id3));
+				if (triangleGroups)
+					triangleGroups->push_back(group);
+			}
+			else
+				for (int i = 1; i < nids-1; i++) {
+					triangles.push_back(int3(vids[0], vids[i], vids[(i+1)%nids]));
+					if (triangleGroups)
+						triangleGroups->push_back(group);
+				}
+		}
+	}
+	fclose(in);
+	return true;
+}
+
+// test file
+
+static long WriteGrid(const char *filename, int n) {
+	// write an n by n heightfield: one group per row, every fourth row of quads,
+	// odd rows use a second copy of the texture coordinates (so their corners split
+	// from the even rows'), normals agree with the winding; return file size
+	FILE *out = fopen(filename, "w");
+	if (!out)
+		return 0;
+	int nVertices = n*n;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < n; i++) {
+			float x = (float) i/(n-1), y = (float) j/(n-1);
+			fprintf(out, "v %f %f %f\n", x, y, .1f*sin(6*x)*cos(6*y));
+		}
+	for (int copy = 0; copy < 2; copy++)
+		for (int k = 0; k < nVertices; k++)
+			fprintf(out, "vt %f %f\n", (float) (k%n)/(n-1), (float) (k/n)/(n-1)+copy);
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < n; i++) {
+			float x = (float) i/(n-1), y = (float) j/(n-1);
+			vec3 nrm = normalize(vec3(-.6f*cos(6*x)*cos(6*y), .6f*sin(6*x)*sin(6*y), 1));
+			fprintf(out, "vn %f %f %f\n", nrm.x, nrm.y, nrm.z);
+		}
+	for (int j = 0; j < n-1; j++) {
+		fprintf(out, "g %d\n", j);
+		int t = j%2? nVertices : 0;
+		for (int i = 0; i < n-1; i++) {
+			int a = j*n+i+1, b = a+1, c = b+n, d = a+n;
+			if (j%4 == 3)
+				fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a+t, a, b, b+t, b, c, c+t, c, d, d+t, d);
+			else {
+				fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a+t, a, b, b+t, b, c, c+t, c);
+				fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a+t, a, c, c+t, c, d, d+t, d);
+			}
+		}
+	}
+	// the original reader repeats the last line at end of file: end with a comment
+	fprintf(out, "# end\n");
+	long size = ftell(out);
+	fclose(out);
+	return size;
+}
+
+static long WriteForwardGrid(const char *filename, int n) {
+	// write an n by n heightfield whose faces follow the vertices row by row: a few faces
+	// precede a vertex they use (the reader drops that corner), textures are written a
+	// third of the way down and normals halfway, so earlier corners lack them; return file size
+	FILE *out = fopen(filename, "w");
+	if (!out)
+		return 0;
+	int nVertices = n*n;
+	for (int j = 0; j < n; j++) {
+		if (j == n/3)
+			for (int k = 0; k < nVertices; k++)
+				fprintf(out, "vt %f %f\n", (float) (k%n)/(n-1), (float) (k/n)/(n-1));
+		if (j == n/2)
+			for (int k = 0; k < nVertices; k++)
+				fprintf(out, "vn 0 %f 1\n", (float) (k%7)/7-.5f);
+		if (j > 0 && j%(n/4) == 0)
+			fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", j*n-n+1, j*n-n+1, j*n-n+1, j*n+1, j*n+1, j*n+1, j*n+2, j*n+2, j*n+2);
+		for (int i = 0; i < n; i++)
+			fprintf(out, "v %f %f %f\n", (float) i/(n-1), (float) j/(n-1), (float) ((i*j)%5)/10);
+		if (j == 0)
+			continue;
+		fprintf(out, "g %d\n", j);
+		for (int i = 0; i < n-1; i++) {
+			int a = (j-1)*n+i+1, b = a+1, c = b+n, d = a+n;
+			fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c);
+			fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d);
+		}
+	}
+	fprintf(out, "# end\n");
+	long size = ftell(out);
+	fclose(out);
+	return size;
+}
+
+template <class T>
+static bool Same(const vector<T> &a, const vector<T> &b) {
+	return a.size() == b.size() && (a.empty() || !memcmp(a.data(), b.data(), a.size()*sizeof(T)));
+}
+
+struct ObjMesh {
+	vector<vec3> points, normals;
+	vector<vec2> textures;
+	vector<int3> triangles;
+	vector<int> groups;
+	bool operator==(const ObjMesh &m) const {
+		return Same(points, m.points) && Same(normals, m.normals) && Same(textures, m.textures) &&
+			   Same(triangles, m.triangles) && Same(groups, m.groups);
+	}
+};
+
+bool ObjBench() {
+	char filename[] = "bench.obj";
+	long size = WriteGrid(filename, 500);
+	if (!size) {
+		printf("can't write %s\n", filename);
+		return false;
+	}
+	UseMeshCache(false);
+	ObjMesh original, parsed;
+	double tOriginal = BestTime([&]() {
+		original = ObjMesh();
+		OriginalReadAsciiObj(filename, original.points, original.triangles, &original.normals, &original.textures, &original.groups);
+	});
+	double tParsed = BestTime([&]() {
+		parsed = ObjMesh();
+		ReadAsciiObj(filename, parsed.points, parsed.triangles, &parsed.normals, &parsed.textures, &parsed.groups);
+	});
+	remove(filename);
+	bool same = parsed == original;
+	printf("  %.1f MB, %d vertices, %d triangles\n", (double) size/(1 << 20), (int) original.points.size(), (int) original.triangles.size());
+	printf("  fgets/sscanf: %7.1f MB/s\n", MBPerSecond(size, tOriginal));
+	printf("  ReadAsciiObj: %7.1f MB/s (%.1fx)%s\n", MBPerSecond(size, tParsed), tOriginal/tParsed, same? "" : ", MESH DIFFERS");
+	return same;
+}
+
+bool ObjThreadsBench() {
+	// time ReadAsciiObj from 1 thread to the hardware concurrency; each mesh must match one thread's
+	char filename[] = "bench.obj";
+	long size = WriteGrid(filename, 700);
+	if (!size) {
+		printf("can't write %s\n", filename);
+		return false;
+	}
+	UseMeshCache(false);
+	int maxThreads = std::thread::hardware_concurrency();
+	maxThreads = maxThreads > 4? maxThreads : 4;		// exercise the parallel reader on small machines
+	bool same = true;
+	ObjMesh serial;
+	double tSerial = 0;
+	printf("  %.1f MB\n", (double) size/(1 << 20));
+	for (int nThreads = 1; nThreads <= maxThreads; nThreads = nThreads < maxThreads && 2*nThreads > maxThreads? maxThreads : 2*nThreads) {
+		ObjMesh m;
+		double t = BestTime([&]() {
+			m = ObjMesh();
+			ReadAsciiObj(filename, m.points, m.triangles, &m.normals, &m.textures, &m.groups, nThreads);
+		});
+		if (nThreads == 1) {
+			serial = m;
+			tSerial = t;
+		}
+		bool sameMesh = m == serial;
+		same = same && sameMesh;
+		printf("  %2d threads: %7.1f MB/s (%.2fx)%s\n", nThreads, MBPerSecond(size, t), tSerial/t, sameMesh? "" : ", MESH DIFFERS");
+	}
+	// forward references: the parallel reader must test each corner against what precedes
+	// its face, as the serial reader does
+	if (!WriteForwardGrid(filename, 400)) {
+		printf("can't write %s\n", filename);
+		return false;
+	}
+	ObjMesh forward[2];
+	for (int k = 0; k < 2; k++)
+		ReadAsciiObj(filename, forward[k].points, forward[k].triangles, &forward[k].normals, &forward[k].textures, &forward[k].groups, k? maxThreads : 1);
+	bool sameForward = forward[0] == forward[1];
+	same = same && sameForward;
+	printf("  forward references, %d vs 1 thread: %s\n", maxThreads, sameForward? "same" : "MESH DIFFERS");
+	remove(filename);
+	return same;
+}
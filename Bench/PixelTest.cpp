@@ -0,0 +1,154 @@
+/*	==============================
+    PixelTest.cpp - BGRToLuminance, SwapRedBlue and WidenTo16 against scalar references
+	=============================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MeshIO.h"
+#include "Bench.h"
+
+// references
+
+static unsigned char Luminance(int r, int g, int b) {
+	// .21 red + .72 green + .07 blue in 15-bit fixed point, rounded
+	return (unsigned char) ((6881*r+23593*g+2294*b+16384) >> 15);
+}
+
+static void ScalarLuminance(const unsigned char *pixels, int nPixels, int bytesPerPixel, unsigned char *luminance) {
+	for (int i = 0; i < nPixels; i++, pixels += bytesPerPixel)
+		luminance[i] = Luminance(pixels[2], pixels[1], pixels[0]);
+}
+
+static void ScalarSwap(unsigned char *pixels, int nPixels, int bytesPerPixel) {
+	for (int i = 0; i < nPixels; i++, pixels += bytesPerPixel) {
+		unsigned char t = pixels[0];
+		pixels[0] = pixels[2];
+		pixels[2] = t;
+	}
+}
+
+static void ScalarWiden(const unsigned char *in, int n, unsigned short *out) {
+	for (int i = 0; i < n; i++)
+		out[i] = (unsigned short) (in[i]*257);
+}
+
+// inputs
+
+enum Fill {F_Random, F_Zero, F_Max, F_Ramp, F_Channel};
+
+static void FillBytes(unsigned char *b, size_t n, Fill fill, unsigned int seed) {
+	// random, all 0, all 255, 0..255 repeated, or 255 in every third byte (one saturated channel)
+	srand(seed);
+	for (size_t i = 0; i < n; i++)
+		b[i] = (unsigned char) (fill == F_Random? rand() : fill == F_Zero? 0 : fill == F_Max? 255 :
+								fill == F_Ramp? i : i%3 == 0? 255 : 0);
+}
+
+static const int guard = 64, guardByte = 0xA5;
+
+static bool GuardsIntact(const vector<unsigned char> &b, size_t nBytes) {
+	// bytes past nBytes (at least guard of them) are still guardByte
+	for (size_t i = nBytes; i < b.size(); i++)
+		if (b[i] != guardByte)
+			return false;
+	return true;
+}
+
+static bool CheckSizes(int nPixels, Fill fill, unsigned int seed) {
+	// every kernel at this size against its reference, in and out of place; report the first failure
+	for (int bpp = 3; bpp <= 4; bpp++) {
+		size_t nBytes = (size_t) nPixels*bpp;
+		vector<unsigned char> pixels(nBytes+guard, guardByte), expect(nPixels+guard, guardByte), lum(nPixels+guard, guardByte);
+		FillBytes(pixels.data(), nBytes, fill, seed);
+		ScalarLuminance(pixels.data(), nPixels, bpp, expect.data());
+		BGRToLuminance(pixels.data(), nPixels, bpp, lum.data());
+		if (lum != expect) {
+			printf("  BGRToLuminance: %d pixels of %d bytes (fill %d) differs\n", nPixels, bpp, fill);
+			return false;
+		}
+		// luminance written over its own pixels
+		vector<unsigned char> inPlace(pixels);
+		BGRToLuminance(inPlace.data(), nPixels, bpp, inPlace.data());
+		if (memcmp(inPlace.data(), expect.data(), nPixels) || !GuardsIntact(inPlace, nBytes)) {
+			printf("  BGRToLuminance in place: %d pixels of %d bytes (fill %d) differs\n", nPixels, bpp, fill);
+			return false;
+		}
+		vector<unsigned char> swapped(pixels), expectSwapped(pixels);
+		SwapRedBlue(swapped.data(), nPixels, bpp);
+		ScalarSwap(expectSwapped.data(), nPixels, bpp);
+		if (swapped != expectSwapped) {
+			printf("  SwapRedBlue: %d pixels of %d bytes (fill %d) differs\n", nPixels, bpp, fill);
+			return false;
+		}
+	}
+	vector<unsigned char> in(nPixels);
+	vector<unsigned short> wide(nPixels+guard, guardByte), expectWide(nPixels+guard, guardByte);
+	FillBytes(in.data(), nPixels, fill, seed);
+	WidenTo16(in.data(), nPixels, wide.data());
+	ScalarWiden(in.data(), nPixels, expectWide.data());
+	if (wide != expectWide) {
+		printf("  WidenTo16: %d values (fill %d) differs\n", nPixels, fill);
+		return false;
+	}
+	return true;
+}
+
+static bool CheckAllColors() {
+	// every 24-bit color through BGRToLuminance, against the reference and within 1 of the
+	// floating-point weights
+	const int nColors = 1 << 24;
+	vector<unsigned char> pixels(3*(size_t) nColors), lum(nColors);
+	for (int c = 0; c < nColors; c++) {
+		pixels[3*c] = (unsigned char) c;
+		pixels[3*c+1] = (unsigned char) (c >> 8);
+		pixels[3*c+2] = (unsigned char) (c >> 16);
+	}
+	BGRToLuminance(pixels.data(), nColors, 3, lum.data());
+	for (int c = 0; c < nColors; c++) {
+		int b = c&255, g = (c >> 8)&255, r = c >> 16;
+		float f = .21f*r+.72f*g+.07f*b, d = lum[c]-f;
+		if (lum[c] != Luminance(r, g, b) || d > 1 || d < -1) {
+			printf("  BGRToLuminance: color %d %d %d gives %d\n", r, g, b, lum[c]);
+			return false;
+		}
+	}
+	return true;
+}
+
+// timing
+
+static void Time(const char *name, double bytes, double tScalar, double t) {
+	printf("  %-15s %8.0f MB/s  (scalar %6.0f MB/s, %.1fx)\n", name, MBPerSecond(bytes, t), MBPerSecond(bytes, tScalar), tScalar/t);
+}
+
+bool PixelTest() {
+	bool ok = true;
+	Fill fills[] = {F_Random, F_Zero, F_Max, F_Ramp, F_Channel};
+	// every size through 40 (tails of 0-3 pixels after each block of 4 or 16), then larger odd sizes
+	for (int f = 0; f < 5 && ok; f++)
+		for (int n = 0; n <= 40 && ok; n++)
+			ok = CheckSizes(n, fills[f], 17*n+f);
+	for (int n = 1001; n < 1020 && ok; n++)
+		ok = CheckSizes(n, F_Random, n);
+	ok = ok && CheckAllColors();
+	printf("  correctness: %s\n", ok? "ok" : "FAILED");
+	// throughput over 16M pixels, counting bytes read
+	const int nPixels = 1 << 24;
+	vector<unsigned char> pixels(4*(size_t) nPixels), lum(nPixels);
+	vector<unsigned short> wide(nPixels);
+	FillBytes(pixels.data(), pixels.size(), F_Random, 1);
+	for (int bpp = 3; bpp <= 4; bpp++) {
+		double bytes = (double) nPixels*bpp;
+		double tScalar = BestTime([&]() { ScalarLuminance(pixels.data(), nPixels, bpp, lum.data()); });
+		double t = BestTime([&]() { BGRToLuminance(pixels.data(), nPixels, bpp, lum.data()); });
+		Time(bpp == 3? "BGRToLuminance" : "BGRAToLuminance", bytes, tScalar, t);
+		tScalar = BestTime([&]() { ScalarSwap(pixels.data(), nPixels, bpp); });
+		t = BestTime([&]() { SwapRedBlue(pixels.data(), nPixels, bpp); });
+		Time(bpp == 3? "SwapRedBlue 24" : "SwapRedBlue 32", bytes, tScalar, t);
+	}
+	double tScalar = BestTime([&]() { ScalarWiden(pixels.data(), nPixels, wide.data()); });
+	double t = BestTime([&]() { WidenTo16(pixels.data(), nPixels, wide.data()); });
+	Time("WidenTo16", nPixels, tScalar, t);
+	return ok;
+}
@@ -8,6 +8,7 @@
 #include <gl/glew.h>
 #include <gl/freeglut.h>
 #include <assert.h>
+#include <vector>
 #include "Draw.h"
 #include "GLSL.h"
 
@@ -66,11 +67,141 @@ bool IsVisible(vec3 &p, mat4 &fullview, vec2 *screenA) {
 	if (screenA)
 		*screenA = screen;
 	float z = xp.z/xp.w, zScreen;
+	FlushDrawList();
 	glReadPixels((int)screen.x, (int)screen.y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &zScreen);
 	zScreen = 2*zScreen-1; // seems to work (clip range +/-1 but zbuffer range 0-1)
 	return z < zScreen;
 }
 
+// Visibility Query
+
+// each submission reads the depth buffer, within the bounds of its points, into a pixel-pack
+// buffer and sets a fence; it is answered once the fence has signalled, typically by the next
+// frame; with two readbacks in flight a submission is dropped, rather than wait on the GL
+
+VisibilityQuery::VisibilityQuery() : next(0), changed(false) {
+	for (int i = 0; i < 2; i++) {
+		readbacks[i].buffer = 0;
+		readbacks[i].capacity = 0;
+		readbacks[i].fence = 0;
+	}
+}
+
+void VisibilityQuery::Release() {
+	for (int i = 0; i < 2; i++) {
+		Readback &r = readbacks[i];
+		if (r.fence)
+			glDeleteSync(r.fence);
+		if (r.buffer)
+			glDeleteBuffers(1, &r.buffer);
+		r.fence = 0;
+		r.buffer = 0;
+		r.capacity = 0;
+	}
+}
+
+void VisibilityQuery::Answer(Readback &r, float *depths) {
+	int n = r.pixels.size();
+	if ((int) visible.size() != n) {
+		visible.assign(n, false);
+		changed = true;
+	}
+	for (int i = 0; i < n; i++) {
+		Pixel &p = r.pixels[i];
+		bool v = p.x >= 0 && p.z < 2*depths[(p.y-r.y)*r.w+p.x-r.x]-1; // depth range 0-1, clip +/-1
+		if (v != visible[i]) {
+			visible[i] = v;
+			changed = true;
+		}
+	}
+}
+
+void VisibilityQuery::Poll() {
+	// answer completed readbacks, oldest first
+	for (int k = 0; k < 2; k++) {
+		Readback &r = readbacks[(next+k)%2];
+		if (!r.fence)
+			continue;
+		GLenum status = glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+			break;
+		GLSL::BindBuffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+		float *depths = (float *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, r.w*r.h*sizeof(float), GL_MAP_READ_BIT);
+		if (depths) {
+			Answer(r, depths);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		GLSL::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glDeleteSync(r.fence);
+		r.fence = 0;
+	}
+}
+
+void VisibilityQuery::Submit(int n, vec3 *points, mat4 &fullview) {
+	Poll();
+	Readback &r = readbacks[next];
+	if (r.fence)
+		return;
+	FlushDrawList();
+	int winW = glutGet(GLUT_WINDOW_WIDTH), winH = glutGet(GLUT_WINDOW_HEIGHT);
+	int x1 = -1, y1 = -1;
+	r.x = winW;
+	r.y = winH;
+	r.pixels.resize(n);
+	for (int i = 0; i < n; i++) {
+		vec4 xp = fullview*vec4(points[i], 1);
+		Pixel &p = r.pixels[i];
+		p.x = (int) ((float) winW/2.f*(1.f+xp.x/xp.w));
+		p.y = (int) ((float) winH/2.f*(1.f+xp.y/xp.w));
+		p.z = xp.z/xp.w;
+		if (xp.w <= 0 || p.x < 0 || p.x >= winW || p.y < 0 || p.y >= winH) {
+			p.x = -1;				// off-screen, not visible
+			continue;
+		}
+		r.x = p.x < r.x? p.x : r.x;
+		r.y = p.y < r.y? p.y : r.y;
+		x1 = p.x > x1? p.x : x1;
+		y1 = p.y > y1? p.y : y1;
+	}
+	r.w = x1-r.x+1;
+	r.h = y1-r.y+1;
+	if (x1 < 0 || !glFenceSync || !glMapBufferRange) {
+		// nothing to read, or GL before 3.2: answer now
+		std::vector<float> depths(x1 < 0? 0 : r.w*r.h);
+		if (x1 >= 0)
+			glReadPixels(r.x, r.y, r.w, r.h, GL_DEPTH_COMPONENT, GL_FLOAT, &depths[0]);
+		Answer(r, depths.empty()? NULL : &depths[0]);
+		return;
+	}
+	GLsizeiptr size = r.w*r.h*sizeof(float);
+	if (!r.buffer)
+		glGenBuffers(1, &r.buffer);
+	GLSL::BindBuffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+	if (size > r.capacity) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		r.capacity = size;
+	}
+	glReadPixels(r.x, r.y, r.w, r.h, GL_DEPTH_COMPONENT, GL_FLOAT, (void *) 0);
+	GLSL::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	next = (next+1)%2;
+}
+
+bool VisibilityQuery::Visible(int i) {
+	Poll();
+	changed = false;
+	return i >= 0 && i < (int) visible.size() && visible[i];
+}
+
+bool VisibilityQuery::Changed() {
+	Poll();
+	return changed;
+}
+
+bool VisibilityQuery::Pending() {
+	return readbacks[0].fence || readbacks[1].fence;
+}
+
 void ScreenPoint(vec3 p, mat4 m, float &xscreen, float &yscreen, float *zscreen) {
 	int width = glutGet(GLUT_WINDOW_WIDTH), height = glutGet(GLUT_WINDOW_HEIGHT);
 	vec4 xp = m*vec4(p, 1);
@@ -173,14 +304,15 @@ vec3 ScreenVec(float xscreen, float yscreen, mat4 &modelview, mat4 &persp) {
 // Draw Shader
 
 int drawShader = 0;
+static GLint positionId = -1, colorId = -1, viewId = -1, opacityId = -1;	// locations in drawShader
 
 char *drawVShader = "\
 	#version 400								\n\
 	// layout (location = 0) in vec3 position;	\n\
 	// layout (location = 1) in vec3 color;		\n\
 	in vec3 position;							\n\
-	in vec3 color;								\n\
-	out vec3 vColor;							\n\
+	in vec4 color;								\n\
+	out vec4 vColor;							\n\
     uniform mat4 view; // persp*modelView       \n\
 	void main()									\n\
 	{											\n\
@@ -191,46 +323,307 @@ char *drawVShader = "\
 char *drawFShader = "\
 	#version 400								\n\
 	uniform float opacity = 1;					\n\
-	in vec3 vColor;								\n\
+	in vec4 vColor;								\n\
 	out vec4 fColor;							\n\
 	void main()									\n\
 	{											\n\
-	    fColor = vec4(vColor, opacity);			\n\
+	    fColor = vec4(vColor.rgb, opacity*vColor.a);\n\
 	}											\n";
 
 int UseDrawShader() {
 	int current = GLSL::CurrentShader();
-	if (!drawShader)
+	if (!drawShader) {
 		drawShader = InitShader(drawVShader, drawFShader);
-	if (current != drawShader)
-		glUseProgram(drawShader);
-	glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_LINE_SMOOTH);
-	glEnable(GL_POINT_SMOOTH);
+		positionId = GLSL::AttributeLocation(drawShader, "position");
+		colorId = GLSL::AttributeLocation(drawShader, "color");
+		viewId = GLSL::UniformLocation(drawShader, "view");
+		opacityId = GLSL::UniformLocation(drawShader, "opacity");
+	}
+	GLSL::UseProgram(drawShader);
+	GLSL::Enable(GL_BLEND);
+    GLSL::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLSL::Enable(GL_LINE_SMOOTH);
+	GLSL::Enable(GL_POINT_SMOOTH);
 	return current;
 }
 
 int UseDrawShader(mat4 viewMatrix) {
+	FlushDrawList();
 	int r = UseDrawShader();
-	GLSL::SetUniform(drawShader, "view", viewMatrix);
+	GLSL::SetUniform(viewId, viewMatrix);
 	return r;
 }
 
-class DrawBuffer {
-public:
-	DrawBuffer() { vBuf = 0; }
-	~DrawBuffer() { } // if (vBuf > 0) glDeleteBuffers(1, &vBuf);
-	GLuint vBuf;
-} dotBuffer, lineBuffer, triBuffer, quadBuffer;
+// Glyph Atlas
+
+// the printable characters of a GLUT bitmap font are rendered once, by glutBitmapCharacter, into
+// the cells of a texture; strings are then collected as textured quads, one per character, and drawn
+// when the draw list is, over the list's other primitives
+
+struct GlyphAtlas {
+	void *font;
+	GLuint texture;
+	int cellW, cellH, descent;		// in pixels; cells are 16 per row
+	int advance[95];				// for ' ' through '~'
+};
+
+struct TextVertex {
+	vec2 point, uv;					// in pixels, in atlas
+	vec3 color;
+};
+
+struct TextRun {
+	GLuint texture;
+	int first, count;
+	TextRun(GLuint t, int f) : texture(t), first(f), count(0) { }
+};
+
+static std::vector<GlyphAtlas> atlases;
+static std::vector<TextVertex> textVertices;
+static std::vector<TextRun> textRuns;
+
+// atlases are bound only to their own texture unit (GL 3 provides at least 16, programs here use
+// the first few), so text neither queries nor restores the application's texture bindings
+
+static const GLenum textUnit = GL_TEXTURE15;
+static GLuint textUnitTexture = 0;				// atlas bound to textUnit
+
+static void BindAtlas(GLuint texture) {
+	// with textUnit active
+	if (texture != textUnitTexture)
+		glBindTexture(GL_TEXTURE_2D, textUnitTexture = texture);
+}
+
+static GlyphAtlas &Atlas(void *font) {
+	for (size_t i = 0; i < atlases.size(); i++)
+		if (atlases[i].font == font)
+			return atlases[i];
+	GlyphAtlas a;
+	a.font = font;
+	a.cellW = 0;
+	for (int i = 0; i < 95; i++)
+		if ((a.advance[i] = glutBitmapWidth(font, ' '+i)) > a.cellW)
+			a.cellW = a.advance[i];
+	a.cellW += 2;					// room for glyphs that overhang their advance
+	a.cellH = glutBitmapHeight(font);
+	a.descent = a.cellH/4;
+	int w = 16*a.cellW, h = 6*a.cellH;
+	GLint viewport[4], frame;						// once per font
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &frame);
+	std::vector<unsigned char> clear(w*h, 0);
+	GLenum unit = GLSL::ActiveTexture();
+	GLSL::ActiveTexture(textUnit);
+	glGenTextures(1, &a.texture);
+	BindAtlas(a.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, &clear[0]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// render glyphs into the texture, each with its origin 1 pixel right of, and descent pixels
+	// above, its cell corner
+	GLuint glyphFrame;
+	glGenFramebuffers(1, &glyphFrame);
+	glBindFramebuffer(GL_FRAMEBUFFER, glyphFrame);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, a.texture, 0);
+	glViewport(0, 0, w, h);
+	int program = GLSL::CurrentShader();
+	GLSL::UseProgram(0); // no text support in GLSL
+	glColor3f(1, 1, 1);
+	for (int i = 0; i < 95; i++) {
+		glWindowPos2i((i%16)*a.cellW+1, (i/16)*a.cellH+a.descent);
+		glutBitmapCharacter(font, ' '+i);
+	}
+	GLSL::UseProgram(program);
+	glBindFramebuffer(GL_FRAMEBUFFER, frame);
+	glDeleteFramebuffers(1, &glyphFrame);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	GLSL::ActiveTexture(unit);
+	atlases.push_back(a);
+	return atlases.back();
+}
+
+static void AppendString(int x, int y, const char *text, vec3 &color, void *font) {
+	if (!*text)
+		return;
+	GlyphAtlas &a = Atlas(font);
+	if (textRuns.empty() || textRuns.back().texture != a.texture)
+		textRuns.push_back(TextRun(a.texture, textVertices.size()));
+	float du = 1.f/16, dv = 1.f/6;
+	size_t nVertices = textVertices.size();
+	textVertices.resize(nVertices+6*strlen(text));
+	TextVertex *v = &textVertices[nVertices];
+	for (int xx = x, yy = y; *text; text++) {
+		if (*text == '\n') {
+			xx = x;
+			yy -= a.cellH;
+			continue;
+		}
+		int i = (unsigned char) *text-' ';
+		if (i < 0 || i >= 95)
+			continue;
+		float x0 = (float) (xx-1), y0 = (float) (yy-a.descent), x1 = x0+a.cellW, y1 = y0+a.cellH;
+		float u0 = (i%16)*du, v0 = (i/16)*dv, u1 = u0+du, v1 = v0+dv;
+		float corners[][4] = {{x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1},
+							  {x1, y1, u1, v1}, {x0, y1, u0, v1}, {x0, y0, u0, v0}};
+		for (int k = 0; k < 6; k++, v++) {
+			float *c = corners[k];
+			v->point = vec2(c[0], c[1]);
+			v->uv = vec2(c[2], c[3]);
+			v->color = color;
+		}
+		xx += a.advance[i];
+	}
+	textVertices.resize(v-&textVertices[0]);
+	textRuns.back().count = textVertices.size()-textRuns.back().first;
+}
+
+static char *textVShader = "\
+	#version 400								\n\
+	in vec2 point;								\n\
+	in vec2 uv;									\n\
+	in vec3 color;								\n\
+	out vec2 vUv;								\n\
+	out vec3 vColor;							\n\
+	uniform vec2 window;						\n\
+	void main()									\n\
+	{											\n\
+		gl_Position = vec4(2*point/window-1, 0, 1);\n\
+		vUv = uv;								\n\
+		vColor = color;							\n\
+	}											\n";
+
+static char *textFShader = "\
+	#version 400								\n\
+	in vec2 vUv;								\n\
+	in vec3 vColor;								\n\
+	out vec4 fColor;							\n\
+	uniform sampler2D atlas;					\n\
+	void main()									\n\
+	{											\n\
+		float a = texture(atlas, vUv).r;		\n\
+		if (a == 0)								\n\
+			discard;							\n\
+		fColor = vec4(vColor, a);					\n\
+	}											\n";
+
+static GLuint textShader = 0;
+static GLint textPointId = -1, uvId = -1, textColorId = -1, windowId = -1, atlasId = -1;	// locations in textShader
+
+static void DrawText() {
+	int current = UseDrawShader();
+	if (!textShader) {
+		textShader = InitShader(textVShader, textFShader);
+		textPointId = GLSL::AttributeLocation(textShader, "point");
+		uvId = GLSL::AttributeLocation(textShader, "uv");
+		textColorId = GLSL::AttributeLocation(textShader, "color");
+		windowId = GLSL::UniformLocation(textShader, "window");
+		atlasId = GLSL::UniformLocation(textShader, "atlas");
+	}
+	GLSL::UseProgram(textShader);
+	GLSL::SetUniform(atlasId, (int) (textUnit-GL_TEXTURE0));
+	GLSL::SetUniform(windowId, vec2((float) glutGet(GLUT_WINDOW_WIDTH), (float) glutGet(GLUT_WINDOW_HEIGHT)));
+	GLintptr offset = GLSL::StreamVertices(&textVertices[0], textVertices.size()*sizeof(TextVertex));
+	GLSL::VertexAttribPointer(textPointId, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *) offset);
+	GLSL::VertexAttribPointer(uvId, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *) (offset+sizeof(vec2)));
+	GLSL::VertexAttribPointer(textColorId, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *) (offset+2*sizeof(vec2)));
+	GLenum unit = GLSL::ActiveTexture();
+	GLSL::ActiveTexture(textUnit);
+	for (size_t i = 0; i < textRuns.size(); i++) {
+		BindAtlas(textRuns[i].texture);
+		glDrawArrays(GL_TRIANGLES, textRuns[i].first, textRuns[i].count);
+	}
+	GLSL::ActiveTexture(unit);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::UseProgram(current);
+	textVertices.clear();
+	textRuns.clear();
+}
+
+// Draw List
+
+// primitives append their vertices to drawVertices; a run is a sequence of vertices drawn by one
+// glDrawArrays, so consecutive primitives of the same kind (and line width or disk size) share a run
+// and submission order is kept; the list is drawn when the outermost EndDrawList is reached, or
+// immediately if no list is open, or beforehand if the view or stipple changes
+
+struct DrawVertex {
+	vec3 point;
+	vec4 color;						// rgb, opacity
+};
+
+struct DrawRun {
+	GLenum mode;					// GL_POINTS, GL_LINES or GL_TRIANGLES
+	float size;						// disk diameter or line width, 0 for triangles
+	int first, count;
+	DrawRun(GLenum m, float s, int f) : mode(m), size(s), first(f), count(0) { }
+};
+
+static std::vector<DrawVertex> drawVertices;
+static std::vector<DrawRun> drawRuns;
+static int drawListDepth = 0;
+
+static DrawVertex *Append(GLenum mode, float size, int nVertices) {
+	if (drawRuns.empty() || drawRuns.back().mode != mode || drawRuns.back().size != size)
+		drawRuns.push_back(DrawRun(mode, size, drawVertices.size()));
+	drawRuns.back().count += nVertices;
+	drawVertices.resize(drawVertices.size()+nVertices);
+	return &drawVertices[drawVertices.size()-nVertices];
+}
+
+static void SetVertex(DrawVertex &v, float *point, float *color, float opacity) {
+	v.point = vec3(point[0], point[1], point[2]);
+	v.color = vec4(color[0], color[1], color[2], opacity);
+}
+
+static void Appended() {
+	if (!drawListDepth)
+		FlushDrawList();
+}
+
+void BeginDrawList() { drawListDepth++; }
+
+void EndDrawList() {
+	if (drawListDepth > 0 && --drawListDepth == 0)
+		FlushDrawList();
+}
+
+void FlushDrawList() {
+	if (drawVertices.empty()) {
+		if (!textVertices.empty())
+			DrawText();
+		return;
+	}
+	int current = UseDrawShader();
+	GLintptr offset = GLSL::StreamVertices(&drawVertices[0], drawVertices.size()*sizeof(DrawVertex));
+	GLSL::VertexAttribPointer(positionId, 3, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (void *) offset);
+	GLSL::VertexAttribPointer(colorId, 4, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (void *) (offset+sizeof(vec3)));
+	SetOpacity(1);
+	float lineWidth = GLSL::LineWidth();
+	for (size_t i = 0; i < drawRuns.size(); i++) {
+		DrawRun &r = drawRuns[i];
+		if (r.mode == GL_LINES)
+			GLSL::LineWidth(r.size);
+		if (r.mode == GL_POINTS)
+			glPointSize(r.size);
+		glDrawArrays(r.mode, r.first, r.count);
+	}
+	GLSL::LineWidth(lineWidth);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::UseProgram(current);
+	drawVertices.clear();
+	drawRuns.clear();
+	if (!textVertices.empty())
+		DrawText();
+}
 
 // Display
 
-void SetOpacity(float opacity) { GLSL::SetUniform(drawShader, "opacity", opacity); }
+void SetOpacity(float opacity) { GLSL::SetUniform(opacityId, opacity); }
 
 // Lines
 
 void Box(vec3 &min, vec3 &max, vec3 &color) {
+	BeginDrawList();
 	// min corresponds with left/bottom/near, max corresponds with right/top/far
 	// 4 lines from left to right
 	Line(vec3(min.x, min.y, min.z), vec3(max.x, min.y, min.z), color); // bottom/near
@@ -247,10 +640,12 @@ void Box(vec3 &min, vec3 &max, vec3 &color) {
 	Line(vec3(min.x, max.y, min.z), vec3(min.x, max.y, max.z), color); // left/top
 	Line(vec3(max.x, min.y, min.z), vec3(max.x, min.y, max.z), color); // right/bottom
 	Line(vec3(max.x, max.y, min.z), vec3(max.x, max.y, max.z), color); // right/top
+	EndDrawList();
 }
 
 void Stipple(int factor, int a,int b,int c,int d,int e,int f,int g,int h,
                          int i,int j,int k,int l,int m,int n,int o,int p) {
+    FlushDrawList();
     GLushort pattern = 0;
     int bits[16] = {a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p};
     for (int index = 0; index < 16; index++) {
@@ -263,70 +658,49 @@ void Stipple(int factor, int a,int b,int c,int d,int e,int f,int g,int h,
 }
 
 bool DashOn(int factor, int off) {
-	GLboolean on = glIsEnabled(GL_LINE_STIPPLE);
-	glEnable(GL_LINE_STIPPLE);
+	FlushDrawList();
+	bool on = GLSL::IsEnabled(GL_LINE_STIPPLE);
+	GLSL::Enable(GL_LINE_STIPPLE);
 	Stipple(factor, (0+off)%16, (1+off)%16, (2+off)%16, (3+off)%16, (8+off)%16, (9+off)%16, (10+off)%16, (11+off)%16);
-	return on != 0;
+	return on;
 }
 
 bool DotOn(int factor, int off) {
-	GLboolean on = glIsEnabled(GL_LINE_STIPPLE);
-	glEnable(GL_LINE_STIPPLE);
+	FlushDrawList();
+	bool on = GLSL::IsEnabled(GL_LINE_STIPPLE);
+	GLSL::Enable(GL_LINE_STIPPLE);
 	Stipple(factor, (0+off)%16, (1+off)%16, (4+off)%16, (5+off)%16, (8+off)%16, (9+off)%16, (12+off)%16, (13+off)%16);
-	return on != 0;
+	return on;
 }
 
-void DashOff() { glDisable(GL_LINE_STIPPLE); }
+void DashOff() {
+	FlushDrawList();
+	GLSL::Disable(GL_LINE_STIPPLE);
+}
+
+void DotOff() {
+	FlushDrawList();
+	GLSL::Disable(GL_LINE_STIPPLE);
+}
 
-void DotOff() { glDisable(GL_LINE_STIPPLE); }
+static void AppendLine(float *pnt1, float *pnt2, float *col1, float *col2, float opacity, float width) {
+	DrawVertex *v = Append(GL_LINES, width, 2);
+	SetVertex(v[0], pnt1, col1, opacity);
+	SetVertex(v[1], pnt2, col2, opacity);
+	Appended();
+}
 
 void Line(float *pnt1, float *pnt2, float *col1, float *col2, float opacity) {
-///	int current = UseDrawShader();
-	// vertex data
-	float points[][3] = {{pnt1[0], pnt1[1], pnt1[2]}, {pnt2[0], pnt2[1], pnt2[2]}},
-		  colors[][3] = {{col1[0], col1[1], col1[2]}, {col2[0], col2[1], col2[2]}};
- 	// create a vertex buffer for the array
-	if (lineBuffer.vBuf <= 0) {
-		glGenBuffers(1, &lineBuffer.vBuf);
-		glBindBuffer(GL_ARRAY_BUFFER, lineBuffer.vBuf);
-		int bufferSize = sizeof(points)+sizeof(colors);
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
-	}
-	if (quadBuffer.vBuf <= 0) {
-		glGenBuffers(1, &quadBuffer.vBuf);
-		glBindBuffer(GL_ARRAY_BUFFER, quadBuffer.vBuf);
-		// allocate buffer memory and load location and color data
-		int bufferSize = sizeof(points)+sizeof(colors);
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
-	}
-    // set active vertex buffer
-    glBindBuffer(GL_ARRAY_BUFFER, lineBuffer.vBuf);
-    // allocate buffer memory and load location and color data
-	glBufferData(GL_ARRAY_BUFFER, sizeof(points)+sizeof(colors), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(points), points);
-    glBufferSubData(GL_ARRAY_BUFFER, sizeof(points), sizeof(colors), colors);
-    // connect shader inputs
-	GLSL::VertexAttribPointer(drawShader, "position", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    GLSL::VertexAttribPointer(drawShader, "color", 3, GL_FLOAT, GL_FALSE, 0, (void *) sizeof(points));
-	GLSL::SetUniform(drawShader, "opacity", opacity);
-	// draw
-	glDrawArrays(GL_LINES, 0, 2);
-	// cleanup
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-///	glUseProgram(current);
+	AppendLine(pnt1, pnt2, col1, col2, opacity, GLSL::LineWidth());
 }
 
 void Line(vec3 &p1, vec3 &p2, vec3 &col, float opacity, float width, bool dashed, bool dotted) {
 	bool was = dashed? DashOn() : dotted? DotOn() : false;
 	dashed? DashOn() : void();
 	dotted? DotOn() : void();
-	float w;
-	glGetFloatv(GL_LINE_WIDTH, &w);
-	glLineWidth(width);
-	Line(p1, p2, col, col, opacity);
+	AppendLine(&p1.x, &p2.x, &col.x, &col.x, opacity, width);
 	if (!was && (dashed || dotted))
 		DashOff();
-	glLineWidth(w);
 }
 
 void Line(vec3 &p1, vec3 &p2, vec3 &col1, vec3 &col2, float opacity) {
@@ -354,31 +728,8 @@ void Disk(vec3 &p, float diameter, vec3 &col, mat4 &fullview, char *text, ...) {
 }
 
 void Disk(float *point, float diameter, float *color, float opacity) {
-	UseDrawShader();
-	// create a vertex buffer
-	if (dotBuffer.vBuf <= 0) {
-		glGenBuffers(1, &dotBuffer.vBuf);
-		glBindBuffer(GL_ARRAY_BUFFER, dotBuffer.vBuf);
-		int bufferSize = 6*sizeof(float);
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
-	}
-	// set active buffer
-	glBindBuffer(GL_ARRAY_BUFFER, dotBuffer.vBuf);
-    // allocate buffer memory and load location and color data
-	// **** write directly via glMap?
-	glBufferData(GL_ARRAY_BUFFER, 6*sizeof(float), NULL, GL_STATIC_DRAW);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, 3*sizeof(float), point);
-	glBufferSubData(GL_ARRAY_BUFFER, 3*sizeof(float), 3*sizeof(float), color);
-	// connect shader inputs
-	GLSL::VertexAttribPointer(drawShader, "position", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-	GLSL::VertexAttribPointer(drawShader, "color", 3, GL_FLOAT, GL_FALSE, 0, (void *) sizeof(vec3));
-	// using layouts:
-    // glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);				// position
-    // glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void *) sizeof(vec3));	// color
-	// draw, cleanup
-	SetOpacity(opacity);
-	glPointSize(diameter);
-	glDrawArrays(GL_POINTS, 0, 1);
+	SetVertex(*Append(GL_POINTS, diameter, 1), point, color, opacity);
+	Appended();
 }
 
 void Disk(vec3 &p, float diameter, vec3 &color, float opacity) {
@@ -396,13 +747,17 @@ void Disk(int x, int y, float diameter, float *color, float opacity) {
 }
 
 void DiskRing(vec3 &p, float outDia, vec3 &outColor, float inDia, vec3 &inColor, float opacity) {
+	BeginDrawList();
 	Disk(p, outDia, outColor, opacity);
 	Disk(p, inDia, inColor, opacity);
+	EndDrawList();
 }
 
 void DiskRing(vec2 &p, float outDia, vec3 &outColor, float inDia, vec3 &inColor, float opacity) {
+	BeginDrawList();
 	Disk(p, outDia, outColor, opacity);
 	Disk(p, inDia, inColor, opacity);
+	EndDrawList();
 }
 
 // Circles
@@ -420,6 +775,7 @@ static bool SetCircle() {
 static bool circleSet = SetCircle();
 
 void Circle(vec2 &p, float dia, vec3 &color) {
+	BeginDrawList();
     float radius = dia/2;
 	vec2 p1 = p+radius*circle[N_CIRCLE_POINTS-1];
     for (int i = 0; i < N_CIRCLE_POINTS; i++) {
@@ -428,6 +784,7 @@ void Circle(vec2 &p, float dia, vec3 &color) {
 		Line(p1.x, p1.y, p2.x, p2.y, color, color);
 		p1 = p2;
     }
+	EndDrawList();
 }
 
 void Circle(vec3 &p, mat4 &m, float dia, vec3 &color, char *msg) {
@@ -440,6 +797,7 @@ void Circle(vec3 &p, mat4 &m, float dia, vec3 &color, char *msg) {
 }
 
 void Circle(vec3 &p, vec3 &n, float rad, vec3 &color, bool dots, float lineWidth, bool dashed) {
+	BeginDrawList();
 	vec3 pts[N_CIRCLE_POINTS];
 	float xa = abs(n.x), ya = abs(n.y), za = abs(n.z);
 	vec3 xaxis(1,0,0), yaxis(0,1,0), zaxis(0,0,1);
@@ -460,6 +818,7 @@ void Circle(vec3 &p, vec3 &n, float rad, vec3 &color, bool dots, float lineWidth
 	}
 	if (!alreadyDashed && dashed)
 		DashOff();
+	EndDrawList();
 }
 
 void Circle(vec3 &base, float diameter, mat4 &modelview, mat4 &persp, vec3 &color) {
@@ -473,6 +832,7 @@ void Circle(vec3 &base, float diameter, mat4 &modelview, mat4 &persp, vec3 &colo
 }
 
 void DrawSphere(vec3 &p, float rad, vec3 &color) {
+	BeginDrawList();
 	static float sqrt2 = (float) sqrt(2.), sqrt5 = (float) sqrt(5.);
 	vec3 xyNormals[] = {vec3( 1,0,0), vec3( sqrt2, sqrt2,0), vec3(0, 1,0), vec3(-sqrt2, sqrt2,0),
 						vec3(-1,0,0), vec3(-sqrt2,-sqrt2,0), vec3(0,-1,0), vec3( sqrt2,-sqrt2,0)};
@@ -483,11 +843,178 @@ void DrawSphere(vec3 &p, float rad, vec3 &color) {
 	Circle(p-vec3(0,0,rad/3.f), vec3(0,0,1), (2/3.f)*sqrt2*rad, color, false);
 	Circle(p+vec3(0,0,2*rad/3.f), vec3(0,0,1), (sqrt5/3.f)*rad, color, false);
 	Circle(p-vec3(0,0,2*rad/3.f), vec3(0,0,1), (sqrt5/3.f)*rad, color, false);
+	EndDrawList();
 }
 
+// Instanced Disks, Circles, Spheres
+
+// each instance is a screen-aligned quad, its corners made from gl_VertexID; the pixel shader
+// cuts a disk, ring or circle from the quad, or shades it as a sphere (at the depth of its center)
+
+struct DrawInstance {
+	vec3 center;
+	vec2 diameters;					// outer, inner; in pixels, or in world space for spheres
+	vec4 color, innerColor;			// rgb, opacity
+};
+
+static char *instanceVShader = "\
+	#version 400								\n\
+	in vec3 center;								\n\
+	in vec2 diameters;							\n\
+	in vec4 color;								\n\
+	in vec4 innerColor;							\n\
+	out vec2 vOffset;							\n\
+	out vec2 vRadii;							\n\
+	out vec4 vColor;							\n\
+	out vec4 vInnerColor;						\n\
+	uniform mat4 view;							\n\
+	uniform vec2 viewport;						\n\
+	uniform bool sphere = false;				\n\
+	void main()									\n\
+	{											\n\
+		vec4 c = view*vec4(center, 1);			\n\
+		vec2 radii = .5*diameters;				\n\
+		if (sphere) {							\n\
+			vec3 row = vec3(view[0][0], view[1][0], view[2][0]);\n\
+			radii *= length(row)*.5*viewport.x/c.w;\n\
+		}										\n\
+		vec2 corner = vec2(gl_VertexID%2 == 0? -1 : 1, gl_VertexID < 2? -1 : 1);\n\
+		vOffset = (radii.x+1)*corner;			\n\
+		vRadii = radii;							\n\
+		vColor = color;							\n\
+		vInnerColor = innerColor;				\n\
+		gl_Position = c+vec4(2*c.w*vOffset/viewport, 0, 0);\n\
+	}											\n";
+
+static char *instanceFShader = "\
+	#version 400								\n\
+	in vec2 vOffset;							\n\
+	in vec2 vRadii;								\n\
+	in vec4 vColor;								\n\
+	in vec4 vInnerColor;						\n\
+	out vec4 fColor;							\n\
+	uniform bool sphere = false;				\n\
+	void main()									\n\
+	{											\n\
+		float r = length(vOffset);				\n\
+		float edge = clamp(vRadii.x+.5-r, 0, 1);\n\
+		vec4 c = mix(vInnerColor, vColor, clamp(r-vRadii.y+.5, 0, 1));\n\
+		if (sphere) {							\n\
+			vec2 q = vOffset/vRadii.x;			\n\
+			c.rgb *= .3+.7*sqrt(max(0, 1-dot(q, q)));\n\
+		}										\n\
+		if (edge*c.a == 0)						\n\
+			discard;							\n\
+		fColor = vec4(c.rgb, edge*c.a);			\n\
+	}											\n";
+
+static GLuint instanceShader = 0;
+static GLint centerId = -1, diametersId = -1, instColorId = -1, innerColorId = -1;
+static GLint instViewId = -1, viewportId = -1, sphereId = -1;	// locations in instanceShader
+static std::vector<DrawInstance> drawInstances;
+
+static DrawInstance *Instances(int n) {
+	drawInstances.resize(n);
+	return n? &drawInstances[0] : NULL;
+}
+
+static void DrawInstances(mat4 &fullview, bool sphere) {
+	int n = drawInstances.size();
+	if (!n)
+		return;
+	FlushDrawList();
+	int current = UseDrawShader();
+	if (!instanceShader) {
+		instanceShader = InitShader(instanceVShader, instanceFShader);
+		centerId = GLSL::AttributeLocation(instanceShader, "center");
+		diametersId = GLSL::AttributeLocation(instanceShader, "diameters");
+		instColorId = GLSL::AttributeLocation(instanceShader, "color");
+		innerColorId = GLSL::AttributeLocation(instanceShader, "innerColor");
+		instViewId = GLSL::UniformLocation(instanceShader, "view");
+		viewportId = GLSL::UniformLocation(instanceShader, "viewport");
+		sphereId = GLSL::UniformLocation(instanceShader, "sphere");
+	}
+	GLSL::UseProgram(instanceShader);
+	int vp[4];
+	glGetIntegerv(GL_VIEWPORT, vp);
+	GLSL::SetUniform(instViewId, fullview);
+	GLSL::SetUniform(viewportId, vec2((float) vp[2], (float) vp[3]));
+	GLSL::SetUniform(sphereId, sphere? 1 : 0);
+	GLintptr offset = GLSL::StreamVertices(&drawInstances[0], n*sizeof(DrawInstance));
+	GLint ids[] = {centerId, diametersId, instColorId, innerColorId}, sizes[] = {3, 2, 4, 4};
+	for (int i = 0; i < 4; i++) {
+		GLSL::VertexAttribPointer(ids[i], sizes[i], GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (void *) offset);
+		if (ids[i] >= 0)
+			glVertexAttribDivisor(ids[i], 1);
+		offset += sizes[i]*sizeof(float);
+	}
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, n);
+	// leave the locations as other programs expect them: per vertex, and disabled
+	for (int i = 0; i < 4; i++)
+		if (ids[i] >= 0) {
+			glVertexAttribDivisor(ids[i], 0);
+			glDisableVertexAttribArray(ids[i]);
+		}
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLSL::UseProgram(current);
+}
+
+void Disks(int n, vec3 *centers, mat4 &fullview, float *diameters, vec3 *colors, float opacity) {
+	DrawInstance *d = Instances(n);
+	for (int i = 0; i < n; i++, d++) {
+		d->center = centers[i];
+		d->diameters = vec2(diameters[i], 0);
+		d->color = d->innerColor = vec4(colors[i], opacity);
+	}
+	DrawInstances(fullview, false);
+}
+
+void Disks(int n, vec3 *centers, mat4 &fullview, float diameter, vec3 &color, float opacity) {
+	DrawInstance *d = Instances(n);
+	for (int i = 0; i < n; i++, d++) {
+		d->center = centers[i];
+		d->diameters = vec2(diameter, 0);
+		d->color = d->innerColor = vec4(color, opacity);
+	}
+	DrawInstances(fullview, false);
+}
+
+void DiskRings(int n, vec3 *centers, mat4 &fullview, float *outDias, vec3 *outColors, float *inDias, vec3 *inColors, float opacity) {
+	DrawInstance *d = Instances(n);
+	for (int i = 0; i < n; i++, d++) {
+		d->center = centers[i];
+		d->diameters = vec2(outDias[i], inDias[i]);
+		d->color = vec4(outColors[i], opacity);
+		d->innerColor = vec4(inColors[i], opacity);
+	}
+	DrawInstances(fullview, false);
+}
+
+void Circles(int n, vec3 *centers, mat4 &fullview, float *diameters, vec3 *colors, float lineWidth) {
+	DrawInstance *d = Instances(n);
+	for (int i = 0; i < n; i++, d++) {
+		d->center = centers[i];
+		d->diameters = vec2(diameters[i]+lineWidth, diameters[i]-lineWidth);
+		d->color = vec4(colors[i], 1);
+		d->innerColor = vec4(colors[i], 0);
+	}
+	DrawInstances(fullview, false);
+}
+
+void Spheres(int n, vec3 *centers, mat4 &fullview, float *radii, vec3 *colors, float opacity) {
+	DrawInstance *d = Instances(n);
+	for (int i = 0; i < n; i++, d++) {
+		d->center = centers[i];
+		d->diameters = vec2(2*radii[i], 0);
+		d->color = d->innerColor = vec4(colors[i], opacity);
+	}
+	DrawInstances(fullview, true);
+}
+
 // Arrows
 
 void Arrow(vec2 &base, vec2 &head, vec3 &col, char *label, double headSize) {
+	BeginDrawList();
 	Line(base.x, base.y, head.x, head.y, col, col);
     if (headSize > 0) {
 	    vec2 v1 = (float)headSize*normalize(head-base), v2(v1.y/2.f, -v1.x/2.f);
@@ -497,6 +1024,7 @@ void Arrow(vec2 &base, vec2 &head, vec3 &col, char *label, double headSize) {
     }
     if (label)
         Text((int) head.x+5, (int) head.y, col, label);
+	EndDrawList();
 }
 
 void ArrowV(vec3 &base, vec3 &vec, mat4 &m, vec3 &col, char *label, double headSize) {
@@ -518,9 +1046,11 @@ vec3 TriangleShrink(vec3 &p1, vec3 &p2, vec3 &p3, float scaleAboutCenter) {
 }
 
 void TriangleLines(vec3 &p1, vec3 &p2, vec3 &p3, vec3 &col, float opacity) {
+	BeginDrawList();
 	Line(p1, p2, col, col, opacity);
 	Line(p2, p3, col, col, opacity);
 	Line(p3, p1, col, col, opacity);
+	EndDrawList();
 }
 
 void TriangleLinesScale(vec3 &p1, vec3 &p2, vec3 &p3, vec3 &col, float scaleAboutCenter, float opacity) {
@@ -534,76 +1064,31 @@ void TriangleShade(vec3 &p1, vec3 &p2, vec3 &p3, vec3 &color, float opacity) {
 }
 
 void Triangle(vec3 &pnt1, vec3 &pnt2, vec3 &pnt3, vec3 &col1, vec3 &col2, vec3 &col3, float opacity) {
-	int current = GLSL::CurrentShader();
-//	if (current != drawShader)
-	UseDrawShader();
-	// align vertex data
-	float points[][3] = {pnt1.x,  pnt1.y,  pnt1.z,  pnt2.x,  pnt2.y,  pnt2.z,  pnt3.x,  pnt3.y,  pnt3.z};
-	float colors[][3] = {col1[0], col1[1], col1[2], col2[0], col2[1], col2[2], col3[0], col3[1], col3[2]};
- 	// create vertex buffer
-	if (lineBuffer.vBuf < 0) {
-		glGenBuffers(1, &triBuffer.vBuf);
-		glBindBuffer(GL_ARRAY_BUFFER, triBuffer.vBuf);
-		int bufferSize = sizeof(points)+sizeof(colors);
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
-	}
-    glBindBuffer(GL_ARRAY_BUFFER, triBuffer.vBuf);
-    // allocate buffer memory and load location and color data
-	glBufferData(GL_ARRAY_BUFFER, sizeof(points)+sizeof(colors), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(points), points);
-    glBufferSubData(GL_ARRAY_BUFFER, sizeof(points), sizeof(colors), colors);
-    // connect shader inputs
-	GLSL::VertexAttribPointer(drawShader, "position", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    GLSL::VertexAttribPointer(drawShader, "color", 3, GL_FLOAT, GL_FALSE, 0, (void *) sizeof(points));
-	GLSL::SetUniform(drawShader, "opacity", opacity);
-	// draw, cleanup
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-//	if (current != drawShader)
-	glUseProgram(current);
+	DrawVertex *v = Append(GL_TRIANGLES, 0, 3);
+	SetVertex(v[0], &pnt1.x, &col1.x, opacity);
+	SetVertex(v[1], &pnt2.x, &col2.x, opacity);
+	SetVertex(v[2], &pnt3.x, &col3.x, opacity);
+	Appended();
 }
 
 // Quads
 
 void Quad(vec3 &pnt1, vec3 &pnt2, vec3 &pnt3, vec3 &pnt4, float *col, float opacity) {
-	int current = UseDrawShader();
-	// align vertex data
-	float points[][3] = {pnt1.x, pnt1.y, pnt1.z, pnt2.x, pnt2.y, pnt2.z, pnt3.x, pnt3.y, pnt3.z, pnt4.x, pnt4.y, pnt4.z};
-	float colors[][3] = {col[0], col[1], col[2], col[0], col[1], col[2], col[0], col[1], col[2], col[0], col[1], col[2]};
- 	// create vertex buffer
-	if (lineBuffer.vBuf < 0) {
-		glGenBuffers(1, &lineBuffer.vBuf);
-		glBindBuffer(GL_ARRAY_BUFFER, lineBuffer.vBuf);
-		int bufferSize = sizeof(points)+sizeof(colors);
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
-	}
-	if (quadBuffer.vBuf <= 0) {
-		glGenBuffers(1, &quadBuffer.vBuf);
-		glBindBuffer(GL_ARRAY_BUFFER, quadBuffer.vBuf);
-		int bufferSize = sizeof(points)+sizeof(colors);
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
-	}
-    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer.vBuf);
-    // allocate buffer memory and load location and color data
-	glBufferData(GL_ARRAY_BUFFER, sizeof(points)+sizeof(colors), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(points), points);
-    glBufferSubData(GL_ARRAY_BUFFER, sizeof(points), sizeof(colors), colors);
-    // connect shader inputs
-	GLSL::VertexAttribPointer(drawShader, "position", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    GLSL::VertexAttribPointer(drawShader, "color", 3, GL_FLOAT, GL_FALSE, 0, (void *) sizeof(points));
-	GLSL::SetUniform(drawShader, "opacity", opacity);
-	// draw, cleanup
-	glDrawArrays(GL_QUADS, 0, 4);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	if (true) return;
-	glUseProgram(current);
+	// as two triangles, so quads share runs with triangles
+	DrawVertex *v = Append(GL_TRIANGLES, 0, 6);
+	float *pnts[] = {&pnt1.x, &pnt2.x, &pnt3.x, &pnt1.x, &pnt3.x, &pnt4.x};
+	for (int i = 0; i < 6; i++)
+		SetVertex(v[i], pnts[i], col, opacity);
+	Appended();
 }
 
 void QuadLines(vec3 &p1, vec3 &p2, vec3 &p3, vec3 &p4, float *col, float opacity) {
+	BeginDrawList();
 	Line(p1, p2, col, col, opacity);
 	Line(p2, p3, col, col, opacity);
 	Line(p3, p4, col, col, opacity);
 	Line(p4, p1, col, col, opacity);
+	EndDrawList();
 }
 
 // Text
@@ -634,14 +1119,8 @@ void PutString(int x, int y, const char *text, vec3 &color, void *f) {
 	if (f && FontSize(f) > 0)
 		SetFont(f);
 	assert(FontSize(font) >= 0);
-	int program = GLSL::CurrentShader();
-	int w = glutGet(GLUT_WINDOW_WIDTH), h = glutGet(GLUT_WINDOW_HEIGHT);
-	glUseProgram(0); // no text support in GLSL
-	float xf = (float) (2*x)/w-1, yf = (float) (2*y)/h-1;
-	glColor3fv(&color.x);
-	glRasterPos2f(xf, yf);
-	glutBitmapString(font, (unsigned char*) text);
-	glUseProgram(program);
+	AppendString(x, y, text, color, font);
+	Appended();
 	SetFont(save);
 }
 
@@ -719,22 +1198,26 @@ void ScreenLine(vec2 &v1, vec2 &v2, vec3 &col) {
 }
 
 void ScreenBox(float x1, float y1, float x2, float y2, vec3 &col) {
+	BeginDrawList();
 	float c[] = {col.x, col.y, col.z};
 	Line(x1, y1, x1, y2, c, c);
 	Line(x1, y2, x2, y2, c, c);
 	Line(x2, y2, x2, y1, c, c);
 	Line(x2, y1, x1, y1, c, c);
+	EndDrawList();
 }
 
 void ScreenTriangle(vec2 &v1, vec2 &v2, vec2 &v3, vec3 &col) {
+	BeginDrawList();
 	ScreenLine(v1, v2, col);
 	ScreenLine(v2, v3, col);
 	ScreenLine(v3, v1, col);
+	EndDrawList();
 }
 
 void Rectangle(int x, int y, int w, int h, float *col, bool solid, float opacity) {
-	float linewidth;
-	glGetFloatv(GL_LINE_WIDTH, &linewidth);
+	BeginDrawList();
+	float linewidth = GLSL::LineWidth();
 	float halfw = .5f*linewidth;
 	float x1 = (float) x, x2 = (float) (x+w), y1 = (float) y, y2 = (float) (y+h);
 	if (solid)
@@ -745,6 +1228,7 @@ void Rectangle(int x, int y, int w, int h, float *col, bool solid, float opacity
 		Line(x1-halfw, y2, x2+halfw, y2, col, col, opacity);
 		Line(x1, y1-halfw, x1, y2+halfw, col, col, opacity);
 	}
+	EndDrawList();
 }
 
 void Axes(vec2 &s, mat4 &rotate, float f, char *xLabel, char *yLabel, char *zLabel) {
@@ -755,6 +1239,7 @@ void Axes(vec2 &s, mat4 &rotate, float f, char *xLabel, char *yLabel, char *zLab
 }
 
 void Cross(vec3 &p, float s, vec3 &col) {
+	BeginDrawList();
 	vec3 p1, p2;
 	for (int n = 0; n < 3; n++)
 		for (int i = 0; i < 3; i++) {
@@ -763,9 +1248,11 @@ void Cross(vec3 &p, float s, vec3 &col) {
 			p2[i] = p[i]-offset;
 			Line(p1, p2, col, col);
 		}
+	EndDrawList();
 }
 
 void Asterisk(vec3 &p, float s, vec3 &col) {
+	BeginDrawList();
 	vec3 p1, p2;
 	for (int i = 0; i < 8; i++) {
 		p1.x = p.x+(i<4? -s : s);
@@ -774,19 +1261,23 @@ void Asterisk(vec3 &p, float s, vec3 &col) {
 		p2 = 2*p-p1;
 		Line(p1, p2, col, col);
 	}
+	EndDrawList();
 }
 
 static float sqrt2o2 = sqrt(2.f)/2.f;
 
 void Asterisk(vec2 &p, float s, vec3 &col) {
+	BeginDrawList();
 	float f = sqrt2o2*s, off[][2] = {{0,s}, {f, f}, {s,0}, {f, -f}};
 	for (int i = 0; i < 4; i++) {
 		float *d = off[i];
 		Line(p.x+d[0], p.y+d[1], p.x-d[0], p.y-d[1], col, col);
 	}
+	EndDrawList();
 }
 
 void Crosshairs(vec2 &s, float radius, vec3 &color) {
+	BeginDrawList();
     float innerRad = .4f*radius;
 	Circle(s, .5f, color);
     Circle(s, 2*innerRad, color);
@@ -794,18 +1285,21 @@ void Crosshairs(vec2 &s, float radius, vec3 &color) {
     Line(s.x+innerRad, s.y, s.x+radius, s.y, color, color);
     Line(s.x, s.y-innerRad, s.x, s.y-radius, color, color);
     Line(s.x, s.y+innerRad, s.x, s.y+radius, color, color);
+	EndDrawList();
 }
 
 void Sun(vec2 &p, vec3 *flashColor) {
+	BeginDrawList();
 	vec3 yel(1, 1, 0), red(1, 0, 0), *col = flashColor? flashColor : &red;
 	// wish small yellow on larger red disk regardless of z-buffer
     Disk(p, 8, yel);
     Disk(p, 12, *col);
     Disk(p, 8, yel);
-	glLineWidth(1.);
+	GLSL::LineWidth(1.);
     for (int r = 0, nRays = 16; r < nRays; r++) {
         float a = 2*3.141592f*(float)r/(nRays-1), dx = cos(a), dy = sin(a);
         float len = 11*(r%2? 1.8f : 2.5f);
         Line(p.x+9*dx, p.y+9*dy, p.x+len*dx, p.y+len*dy, *col, *col);
     }
+	EndDrawList();
 }
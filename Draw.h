@@ -10,6 +10,7 @@
 #include <gl/glew.h>
 #include <gl/freeglut.h>
 #include "mat.h"
+#include <vector>
 
 // OpenGL errors
 int Errors(char *buf);
@@ -39,6 +40,39 @@ float ScreenDistSq(int x, int y, vec3 p, mat4 m, float *zscreen = NULL);
 float ScreenDistSq(vec3 &p1, vec3 &p2, mat4 &view);
 	// as above, but between two points
 
+// asynchronous visibility
+//     batched alternative to IsVisible
+class VisibilityQuery {
+public:
+	VisibilityQuery();
+	void Submit(int n, vec3 *points, mat4 &fullview);
+		// once the scene is drawn, read the depth buffer under the n transformed points without
+		// waiting on the GL (GL 3.2+); the answers are typically available by the next frame
+	bool Visible(int i);
+		// was point i visible, according to the latest answered submission? (false if none)
+	bool Changed();
+		// have answers arrived that differ from those last returned by Visible?
+		// (to redisplay, eg from a timer, after the scene has stopped changing)
+	bool Pending();
+		// is a submission yet to be answered?
+	void Release();
+		// delete GL buffers and fences (while the GL context exists)
+private:
+	struct Pixel { int x, y; float z; };		// x < 0 if off-screen
+	struct Readback {
+		GLuint buffer;
+		GLsizeiptr capacity;
+		GLsync fence;
+		int x, y, w, h;							// pixels read
+		std::vector<Pixel> pixels;
+	} readbacks[2];
+	int next;									// readback for next submission
+	bool changed;
+	std::vector<bool> visible;
+	void Poll();
+	void Answer(Readback &r, float *depths);
+};
+
 // misc operations
 vec3 Ortho(vec3 &v);
 	// perpendicular vector of the same length
@@ -52,6 +86,16 @@ int UseDrawShader(mat4 viewMatrix);
 	// as above, but update view transformation
 void SetOpacity(float opacity);
 
+// draw list
+void BeginDrawList();
+	// subsequent points, lines, triangles and quads are collected and drawn together, with as
+	// few draw calls as their order allows; lists nest
+void EndDrawList();
+	// draw the collected primitives if this ends the outermost list
+void FlushDrawList();
+	// draw any collected primitives now (needed only before changing GL state the
+	// primitives depend on, such as depth test or blending, other than through these routines)
+
 // 3D line
 void Line(vec3 &p1, vec3 &p2, vec3 &color, float opacity = 1, float width = 1, bool dashed = false, bool dotted = false);
 	// draw line between 3D endpoints p1, p2 with given color
@@ -85,6 +129,17 @@ void Circle(vec3 &base, float diameter, mat4 &modelview, mat4 &persp, vec3 &colo
 
 void DrawSphere(vec3 &p, float rad, vec3 &color);
 
+// instanced disks, circles, spheres
+//     each draws n items with one instanced draw call (GL 3.3+); centers are transformed by fullview
+//     (persp*modelview); disks, rings and circles have pixel diameters at the transformed centers;
+//     spheres are shaded impostors with world-space radii
+void Disks(int n, vec3 *centers, mat4 &fullview, float *diameters, vec3 *colors, float opacity = 1);
+void Disks(int n, vec3 *centers, mat4 &fullview, float diameter, vec3 &color, float opacity = 1);
+	// as above, but with common diameter and color
+void DiskRings(int n, vec3 *centers, mat4 &fullview, float *outDias, vec3 *outColors, float *inDias, vec3 *inColors, float opacity = 1);
+void Circles(int n, vec3 *centers, mat4 &fullview, float *diameters, vec3 *colors, float lineWidth = 1);
+void Spheres(int n, vec3 *centers, mat4 &fullview, float *radii, vec3 *colors, float opacity = 1);
+
 // arrow
 void Arrow(vec2 &base, vec2 &head, vec3 &color, char *label = NULL, double headSize = 4);
 	// display an arrow between base and head
@@ -122,6 +177,7 @@ void *SetFont(void *font = GLUT_BITMAP_9_BY_15);
 void *GetFont();
 void *SetBold();
 void PutString(int x, int y, const char *text, vec3 &color, void *font = NULL);
+	// text is drawn from a glyph texture, with the draw list (over its other primitives)
 int Text(int x, int y, vec3 &color, char *format, ...);
 	// position null-terminated text at pixel (x, y)
 void Text(vec3 &p, mat4 &m, char *text, vec3 &color = vec3(0));
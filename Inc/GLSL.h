@@ -31,7 +31,49 @@ int CompileShaderViaCode(const char *code, int type);
 int LinkProgramViaFile(const char *vertexShaderFile, const char *fragmentShaderFile);
 int LinkProgramViaCode(const char *vertexShaderCode, const char *fragmentShaderCode, const char *geometryShaderCode = NULL);
 int LinkProgram(int vshader, int fshader, int gshader = -1);
+int LinkProgramViaCode(const char *vertexShaderCode,
+					   const char *tessControlShaderCode,
+					   const char *tessEvaluationShaderCode,
+					   const char *geometryShaderCode,
+					   const char *fragmentShaderCode);
+	// any stage but vertex and fragment may be NULL
+
+// Program Binary Cache
+//     if set, LinkProgramViaCode (and InitShader) reload a program linked on an earlier run,
+//     rather than compile it, if the sources, GL renderer and GL version are unchanged;
+//     this requires GL 4.1 or ARB_get_program_binary and is otherwise ignored
+void SetProgramCache(const char *folder);
+	// folder must exist; NULL disables the cache (the default)
+
+// State Cache
+//     GL state set by these calls is remembered: a call that would not change it is skipped, and
+//     a query is answered without a round-trip to the GL; the cache can't see the GL called
+//     directly, so mixing direct glUseProgram, glBindBuffer, glEnable, glDisable, glBlendFunc,
+//     glLineWidth or glActiveTexture calls with these is unsupported: set that state only through
+//     here; code that can't (another library) must be followed by ForgetState before these are
+//     used again
 int CurrentShader();
+void UseProgram(int shader);
+void BindBuffer(GLenum target, GLuint buffer);
+	// GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are remembered, other targets pass through
+void Enable(GLenum cap, bool enable = true);
+void Disable(GLenum cap);
+bool IsEnabled(GLenum cap);
+void BlendFunc(GLenum src, GLenum dst);
+void LineWidth(float width);
+float LineWidth();
+void ActiveTexture(GLenum unit);
+GLenum ActiveTexture();
+void ForgetState();
+	// discard the remembered state; each value is queried again when next needed
+
+// Vertex Streaming
+//     for vertices rewritten every frame: the data are copied to a ring buffer shared by all callers,
+//     without reallocation or synchronization with the GL (GL 3.2+; otherwise the buffer is re-specified);
+//     with GL 4.4 or ARB_buffer_storage the ring stays mapped, else each copy maps its range
+GLintptr StreamVertices(const void *data, GLsizeiptr size);
+	// return offset of the copy in the stream buffer, which is left bound to GL_ARRAY_BUFFER;
+	// the data may be overwritten by a later call once drawing from it has finished
 
 // Uniform Access
 //     if in debug mode, print any failure to find uniform
@@ -49,6 +91,24 @@ bool SetUniform3v(int shader, const char *name, int count, float *v);
 bool SetUniform4v(int shader, const char *name, int count, float *v);
 bool SetUniform(int shader, const char *name, mat4 m);
 
+// Location Cache
+//     a program's active uniform and attribute locations are read once, when it is linked by
+//     LinkProgram or first accessed by name; the name-based calls here use the cache
+int UniformLocation(int shader, const char *name);
+int AttributeLocation(int shader, const char *name);
+	// -1 if not found
+void ForgetLocations(int shader);
+	// discard the cache for a program deleted or relinked other than by LinkProgram
+
+// Uniform Access by Location
+//     location from UniformLocation; return false, without a GL call, if location < 0
+bool SetUniform(GLint location, int val);
+bool SetUniform(GLint location, float val);
+bool SetUniform(GLint location, vec2 v);
+bool SetUniform(GLint location, vec3 v);
+bool SetUniform(GLint location, vec4 v);
+bool SetUniform(GLint location, mat4 m);
+
 // Attribute Access
 //     if in debug mode, print any failure to find attribute
 int EnableVertexAttribute(int shader, const char *name);
@@ -58,6 +118,9 @@ void DisableVertexAttribute(int shader, const char *name);
 void VertexAttribPointer(int shader, const char *name, GLint ncomponents, GLenum datatype,
 						 GLboolean normalized, GLsizei stride, const GLvoid *pointer);
 	// convenience routine to find and set named attribute
+void VertexAttribPointer(GLint location, GLint ncomponents, GLenum datatype,
+						 GLboolean normalized, GLsizei stride, const GLvoid *pointer);
+	// enable and set attribute at location (from AttributeLocation), unless location < 0
 
 } // end namespace GLSL
 
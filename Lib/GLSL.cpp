@@ -6,6 +6,12 @@
 */
 
 #include "GLSL.h"
+#include <freeglut.h>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
 
 // Support
 
@@ -161,6 +167,87 @@ int GLSL::CompileShaderViaCode(const char *code, GLint type) {
     return shader;
 }
 
+// Location Cache
+
+// per program, the name and location of each active uniform and attribute, with the base name of
+// an array added for its element 0; a name not found (an inactive variable, an array element) is
+// looked up once and added; a linear search by strcmp is cheaper than the driver's hashed lookup
+
+struct Location {
+	string name;
+	GLint location;
+	Location(const char *n, GLint l) : name(n), location(l) { }
+};
+
+struct ProgramLocations {
+	int program;
+	vector<Location> uniforms, attributes;
+};
+
+static vector<ProgramLocations> programLocations;
+static size_t lastProgram = 0;						// most recent index into programLocations
+
+static void AddActive(int program, bool uniforms, vector<Location> &locations) {
+	GLint n = 0, maxLength = 0, size, length;
+	GLenum type;
+	glGetProgramiv(program, uniforms? GL_ACTIVE_UNIFORMS : GL_ACTIVE_ATTRIBUTES, &n);
+	glGetProgramiv(program, uniforms? GL_ACTIVE_UNIFORM_MAX_LENGTH : GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	vector<char> name(maxLength+1);
+	for (int i = 0; i < n; i++) {
+		length = 0;
+		if (uniforms)
+			glGetActiveUniform(program, i, maxLength+1, &length, &size, &type, &name[0]);
+		else
+			glGetActiveAttrib(program, i, maxLength+1, &length, &size, &type, &name[0]);
+		name[length] = 0;
+		GLint location = uniforms? glGetUniformLocation(program, &name[0]) : glGetAttribLocation(program, &name[0]);
+		locations.push_back(Location(&name[0], location));
+		if (length > 3 && !strcmp(&name[length-3], "[0]")) {
+			name[length-3] = 0;
+			locations.push_back(Location(&name[0], location));
+		}
+	}
+}
+
+static ProgramLocations &Locations(int program) {
+	if (lastProgram < programLocations.size() && programLocations[lastProgram].program == program)
+		return programLocations[lastProgram];
+	for (lastProgram = 0; lastProgram < programLocations.size(); lastProgram++)
+		if (programLocations[lastProgram].program == program)
+			return programLocations[lastProgram];
+	programLocations.push_back(ProgramLocations());
+	ProgramLocations &p = programLocations.back();
+	p.program = program;
+	AddActive(program, true, p.uniforms);
+	AddActive(program, false, p.attributes);
+	return p;
+}
+
+static GLint Find(int program, vector<Location> &locations, const char *name, bool uniform) {
+	for (size_t i = 0; i < locations.size(); i++)
+		if (!strcmp(locations[i].name.c_str(), name))
+			return locations[i].location;
+	GLint location = uniform? glGetUniformLocation(program, name) : glGetAttribLocation(program, name);
+	locations.push_back(Location(name, location));
+	return location;
+}
+
+int GLSL::UniformLocation(int shader, const char *name) {
+	return shader > 0? Find(shader, Locations(shader).uniforms, name, true) : -1;
+}
+
+int GLSL::AttributeLocation(int shader, const char *name) {
+	return shader > 0? Find(shader, Locations(shader).attributes, name, false) : -1;
+}
+
+void GLSL::ForgetLocations(int shader) {
+	for (size_t i = 0; i < programLocations.size(); i++)
+		if (programLocations[i].program == shader) {
+			programLocations.erase(programLocations.begin()+i);
+			break;
+		}
+}
+
 // Linking
 
 int GLSL::LinkProgramViaFile(const char *vertexShaderFile, const char *fragmentShaderFile) {
@@ -172,45 +259,445 @@ int GLSL::LinkProgramViaFile(const char *vertexShaderFile, const char *fragmentS
 int GLSL::LinkProgramViaCode(const char *vertexShaderCode,
 	                         const char *fragmentShaderCode,
 							 const char *geometryShaderCode) {
-	int vshader = CompileShaderViaCode(vertexShaderCode, GL_VERTEX_SHADER);
-	int fshader = CompileShaderViaCode(fragmentShaderCode, GL_FRAGMENT_SHADER);
-	int gshader = -1;
-	if (geometryShaderCode)
-		gshader = CompileShaderViaCode(geometryShaderCode, GL_GEOMETRY_SHADER);
-	return LinkProgram(vshader, fshader, gshader);
+	return LinkProgramViaCode(vertexShaderCode, NULL, NULL, geometryShaderCode, fragmentShaderCode);
+}
+
+static int Link(const int *shaders, int nShaders, bool retrievable) {
+	int programID = glCreateProgram();
+	if (programID > 0) {
+		for (int i = 0; i < nShaders; i++)
+			glAttachShader(programID, shaders[i]);
+		if (retrievable)
+			glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		// link and verify
+		glLinkProgram(programID);
+		GLint status;
+		glGetProgramiv(programID, GL_LINK_STATUS, &status);
+		// if (status == GL_FALSE)
+		GLSL::PrintProgramLog(programID);
+		if (status == GL_TRUE) {
+			GLSL::PrintProgramAttributes(programID);
+			GLSL::PrintProgramUniforms(programID);
+		}
+		// a new program may reuse the id of a deleted one
+		GLSL::ForgetLocations(programID);
+		if (status == GL_TRUE)
+			Locations(programID);
+	}
+	return programID;
 }
 
 int GLSL::LinkProgram(int vshader, int fshader, int gshader) {
-    int programID = 0;
-    // create shader program
-    if (vshader && fshader)
-        programID = glCreateProgram();
-    if (programID > 0) {
-        // attach shaders to program
-        glAttachShader(programID, vshader);
-        glAttachShader(programID, fshader);
-		if (gshader >= 0)
-			glAttachShader(programID, gshader);
-        // link and verify
-        glLinkProgram(programID);
-        GLint status;
-        glGetProgramiv(programID, GL_LINK_STATUS, &status);
-        // if (status == GL_FALSE)
-        PrintProgramLog(programID);
-	    if (status == GL_TRUE) {
-			PrintProgramAttributes(programID);
-			PrintProgramUniforms(programID);
+	int shaders[] = {vshader, fshader, gshader};
+	return vshader && fshader? Link(shaders, gshader >= 0? 3 : 2, false) : 0;
+}
+
+// Program Binary Cache
+
+// a linked program is saved as <folder>/<key>.glprogram, the key a hash of the shader sources and
+// the GL renderer and version; a binary the driver rejects (after a driver update, say) is
+// replaced by compiling the sources again
+
+static string programCache;							// folder, empty if the cache is off
+
+struct ProgramHeader {
+	char magic[8];									// "GLPROG"
+	int version;
+	GLenum format;
+	GLint length;
+};
+
+static const int programCacheVersion = 1;
+
+void GLSL::SetProgramCache(const char *folder) {
+	programCache = folder? folder : "";
+}
+
+static bool BinariesSupported() {
+	static int nFormats = -1;
+	if (nFormats < 0) {
+		nFormats = 0;
+		if (glGetProgramBinary && glProgramBinary && glProgramParameteri)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nFormats);
+	}
+	return nFormats > 0;
+}
+
+static void Hash(unsigned long long &h, const char *s, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		h = (h^(unsigned char) s[i])*1099511628211ULL;	// FNV-1a
+}
+
+static string ProgramFile(const char **codes, int nStages) {
+	unsigned long long h = 14695981039346656037ULL;
+	const char *driver[] = {(const char *) glGetString(GL_RENDERER), (const char *) glGetString(GL_VERSION)};
+	for (int i = 0; i < 2; i++)
+		if (driver[i])
+			Hash(h, driver[i], strlen(driver[i])+1);
+	for (int i = 0; i < nStages; i++)
+		// stage index distinguishes the same code in different stages
+		if (codes[i]) {
+			char stage = (char) i;
+			Hash(h, &stage, 1);
+			Hash(h, codes[i], strlen(codes[i])+1);
 		}
-    }
-    return programID;
+	char name[40];
+	sprintf(name, "/%08x%08x.glprogram", (unsigned) (h>>32), (unsigned) h);
+	return programCache+name;
+}
+
+static int LoadProgram(const string &filename) {
+	FILE *in = fopen(filename.c_str(), "rb");
+	if (!in)
+		return 0;
+	ProgramHeader header;
+	vector<char> binary;
+	bool ok = fread(&header, sizeof(header), 1, in) == 1 &&
+			  !memcmp(header.magic, "GLPROG", 7) && header.version == programCacheVersion && header.length > 0;
+	if (ok) {
+		binary.resize(header.length);
+		ok = fread(&binary[0], 1, header.length, in) == (size_t) header.length;
+	}
+	fclose(in);
+	if (!ok)
+		return 0;
+	int programID = glCreateProgram();
+	GLint status = GL_FALSE;
+	if (programID > 0) {
+		glProgramBinary(programID, header.format, &binary[0], header.length);
+		glGetProgramiv(programID, GL_LINK_STATUS, &status);
+	}
+	if (status == GL_FALSE) {
+		if (programID > 0)
+			glDeleteProgram(programID);
+		return 0;
+	}
+	GLSL::ForgetLocations(programID);
+	Locations(programID);
+	return programID;
+}
+
+static void SaveProgram(int programID, const string &filename) {
+	GLint status = GL_FALSE, length = 0;
+	glGetProgramiv(programID, GL_LINK_STATUS, &status);
+	if (status == GL_TRUE)
+		glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	ProgramHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "GLPROG", 7);
+	header.version = programCacheVersion;
+	vector<char> binary(length);
+	glGetProgramBinary(programID, length, &header.length, &header.format, &binary[0]);
+	FILE *out = header.length > 0? fopen(filename.c_str(), "wb") : NULL;
+	if (!out)
+		return;
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+			  fwrite(&binary[0], 1, header.length, out) == (size_t) header.length;
+	if (fclose(out) != 0 || !ok)
+		remove(filename.c_str());					// a partial file would only be rejected later
+}
+
+int GLSL::LinkProgramViaCode(const char *vertexShaderCode,
+							 const char *tessControlShaderCode,
+							 const char *tessEvaluationShaderCode,
+							 const char *geometryShaderCode,
+							 const char *fragmentShaderCode) {
+	const char *codes[] = {vertexShaderCode, tessControlShaderCode, tessEvaluationShaderCode,
+						   geometryShaderCode, fragmentShaderCode};
+	GLenum types[] = {GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER,
+					  GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER};
+	if (!vertexShaderCode || !fragmentShaderCode)
+		return 0;
+	bool cache = !programCache.empty() && BinariesSupported();
+	string filename = cache? ProgramFile(codes, 5) : "";
+	int programID = cache? LoadProgram(filename) : 0;
+	if (programID)
+		return programID;
+	int shaders[5], nShaders = 0, nFailed = 0;
+	for (int i = 0; i < 5; i++)
+		if (codes[i]) {
+			// compile every stage, to report all errors
+			int shader = CompileShaderViaCode(codes[i], types[i]);
+			if (shader)
+				shaders[nShaders++] = shader;
+			else
+				nFailed++;
+		}
+	if (nFailed)
+		return 0;
+	programID = Link(shaders, nShaders, cache);
+	if (cache && programID > 0)
+		SaveProgram(programID, filename);
+	return programID;
+}
+
+// State Cache
+
+// each value is queried from GL at most once, when first needed after start-up or ForgetState;
+// thereafter it is updated only by the calls below
+
+static int program = 0;
+static bool programKnown = false;
+
+struct BufferBinding {
+	GLenum target;
+	GLuint buffer;
+	bool known;
+} bufferBindings[] = {{GL_ARRAY_BUFFER, 0, false}, {GL_ELEMENT_ARRAY_BUFFER, 0, false}};
+
+static const int nBufferBindings = sizeof(bufferBindings)/sizeof(bufferBindings[0]);
+
+struct Capability {
+	GLenum cap;
+	bool enabled;
+	Capability(GLenum c, bool e) : cap(c), enabled(e) { }
+};
+
+static vector<Capability> capabilities;			// the known subset; small, so searched linearly
+static GLenum blendSrc = GL_ONE, blendDst = GL_ZERO;
+static bool blendKnown = false;
+static float lineWidth = -1;						// < 0 if unknown
+static GLint activeTexture = 0;					// 0 if unknown, else GL_TEXTUREi
+
+static BufferBinding *Binding(GLenum target) {
+	for (int i = 0; i < nBufferBindings; i++)
+		if (bufferBindings[i].target == target)
+			return bufferBindings+i;
+	return NULL;
+}
+
+static Capability *FindCapability(GLenum cap) {
+	for (size_t i = 0; i < capabilities.size(); i++)
+		if (capabilities[i].cap == cap)
+			return &capabilities[i];
+	return NULL;
 }
 
 int GLSL::CurrentShader() {
-	int shader = 0;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
-	return shader;
+	if (!programKnown) {
+		glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+		programKnown = true;
+	}
+	return program;
+}
+
+void GLSL::UseProgram(int shader) {
+	if (programKnown && shader == program)
+		return;
+	glUseProgram(shader);
+	program = shader;
+	programKnown = true;
+}
+
+void GLSL::BindBuffer(GLenum target, GLuint buffer) {
+	BufferBinding *b = Binding(target);
+	if (b && b->known && b->buffer == buffer)
+		return;
+	glBindBuffer(target, buffer);
+	if (b) {
+		b->buffer = buffer;
+		b->known = true;
+	}
+}
+
+void GLSL::Enable(GLenum cap, bool enable) {
+	Capability *c = FindCapability(cap);
+	if (c && c->enabled == enable)
+		return;
+	if (enable)
+		glEnable(cap);
+	else
+		glDisable(cap);
+	if (c)
+		c->enabled = enable;
+	else
+		capabilities.push_back(Capability(cap, enable));
+}
+
+void GLSL::Disable(GLenum cap) {
+	Enable(cap, false);
+}
+
+bool GLSL::IsEnabled(GLenum cap) {
+	Capability *c = FindCapability(cap);
+	if (c)
+		return c->enabled;
+	bool enabled = glIsEnabled(cap) == GL_TRUE;
+	capabilities.push_back(Capability(cap, enabled));
+	return enabled;
+}
+
+void GLSL::BlendFunc(GLenum src, GLenum dst) {
+	if (blendKnown && src == blendSrc && dst == blendDst)
+		return;
+	glBlendFunc(src, dst);
+	blendSrc = src;
+	blendDst = dst;
+	blendKnown = true;
+}
+
+void GLSL::LineWidth(float width) {
+	if (width == lineWidth)
+		return;
+	glLineWidth(width);
+	lineWidth = width;
+}
+
+float GLSL::LineWidth() {
+	if (lineWidth < 0)
+		glGetFloatv(GL_LINE_WIDTH, &lineWidth);
+	return lineWidth;
+}
+
+void GLSL::ActiveTexture(GLenum unit) {
+	if (unit == (GLenum) activeTexture)
+		return;
+	glActiveTexture(unit);
+	activeTexture = unit;
+}
+
+GLenum GLSL::ActiveTexture() {
+	if (!activeTexture)
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	return activeTexture;
+}
+
+void GLSL::ForgetState() {
+	programKnown = false;
+	for (int i = 0; i < nBufferBindings; i++)
+		bufferBindings[i].known = false;
+	capabilities.clear();
+	blendKnown = false;
+	lineWidth = -1;
+	activeTexture = 0;
 }
 
+// Vertex Streaming
+
+// the stream buffer is a ring of three segments; uploads are written sequentially into the current
+// segment, so they neither reallocate nor wait on the GL; when a segment is full it is fenced and the
+// next is used, after waiting (rarely) for the GL to finish drawing from that segment's previous
+// contents; with ARB_buffer_storage (GL 4.4) the ring is mapped once, persistently and coherently,
+// and uploads are plain copies; otherwise each upload maps its range unsynchronized
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+typedef void (GLAPIENTRY *BufferStorageProc)(GLenum target, GLsizeiptr size, const GLvoid *data, GLbitfield flags);
+
+static const int nStreamSegments = 3;
+static const GLsizeiptr minStreamSegment = 1<<18;
+static GLuint streamBuffer = 0;
+static GLsizeiptr streamSegment = 0;				// bytes per segment
+static GLsizeiptr streamOffset = 0;				// next free byte in current segment
+static int streamIndex = 0;							// current segment
+static GLsync streamFences[nStreamSegments] = {0, 0, 0};
+static BufferStorageProc bufferStorage = NULL;		// glBufferStorage, if supported
+static bool bufferStorageKnown = false;
+static char *streamMapping = NULL;					// whole ring, if persistently mapped
+
+static void WaitFence(GLsync &fence) {
+	if (!fence)
+		return;
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+static BufferStorageProc BufferStorage() {
+	// glBufferStorage if GL is 4.4+ or lists ARB_buffer_storage (the bundled GLEW predates it)
+	if (!bufferStorageKnown) {
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		if (major > 4 || (major == 4 && minor >= 4) || glewGetExtension("GL_ARB_buffer_storage"))
+			bufferStorage = (BufferStorageProc) glutGetProcAddress("glBufferStorage");
+		bufferStorageKnown = true;
+	}
+	return bufferStorage;
+}
+
+static void AllocateStream(GLsizeiptr size) {
+	// a ring of segments of at least size bytes; the old storage is orphaned (or, if immutable,
+	// deleted, which GL defers until drawing from it is done), so needn't be waited for
+	for (int i = 0; i < nStreamSegments; i++)
+		if (streamFences[i]) {
+			glDeleteSync(streamFences[i]);
+			streamFences[i] = 0;
+		}
+	for (streamSegment = minStreamSegment; streamSegment < size; streamSegment *= 2)
+		;
+	GLsizeiptr ringSize = nStreamSegments*streamSegment;
+	if (streamMapping) {
+		GLSL::BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);		// a deleted buffer's name may be reused
+		glDeleteBuffers(1, &streamBuffer);
+		streamBuffer = 0;
+		streamMapping = NULL;
+	}
+	if (!streamBuffer)
+		glGenBuffers(1, &streamBuffer);
+	GLSL::BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+	if (BufferStorage()) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		bufferStorage(GL_ARRAY_BUFFER, ringSize, NULL, flags);
+		streamMapping = (char *) glMapBufferRange(GL_ARRAY_BUFFER, 0, ringSize, flags);
+		if (!streamMapping) {
+			// storage is immutable: start over with a buffer mapped per upload
+			bufferStorage = NULL;
+			GLSL::BindBuffer(GL_ARRAY_BUFFER, 0);
+			glDeleteBuffers(1, &streamBuffer);
+			glGenBuffers(1, &streamBuffer);
+			GLSL::BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+		}
+	}
+	if (!streamMapping)
+		glBufferData(GL_ARRAY_BUFFER, ringSize, NULL, GL_STREAM_DRAW);
+	streamIndex = 0;
+	streamOffset = 0;
+}
+
+GLintptr GLSL::StreamVertices(const void *data, GLsizeiptr size) {
+	if (!glMapBufferRange || !glFenceSync || !glClientWaitSync) {
+		// GL before 3.2: re-specify the buffer
+		if (!streamBuffer)
+			glGenBuffers(1, &streamBuffer);
+		BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+		glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
+		return 0;
+	}
+	if (size > streamSegment)
+		AllocateStream(size);
+	else if (streamOffset+size > streamSegment) {
+		streamFences[streamIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		streamIndex = (streamIndex+1)%nStreamSegments;
+		WaitFence(streamFences[streamIndex]);
+		streamOffset = 0;
+	}
+	BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+	GLintptr offset = streamIndex*streamSegment+streamOffset;
+	if (streamMapping)
+		memcpy(streamMapping+offset, data, size);
+	else {
+		void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+										GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (mapped) {
+			memcpy(mapped, data, size);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		else
+			glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	}
+	streamOffset += (size+15) & ~15;				// keep offsets 16-byte aligned
+	return offset;
+}
+
 bool Error(const char *name) {
 #ifdef _DEBUG
 	printf("can't find shader variable %s\n", name);
@@ -221,7 +708,7 @@ bool Error(const char *name) {
 // Uniform Access
 
 bool GLSL::SetUniform(int shader, const char *name, int val) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform1i(id, val);
@@ -229,7 +716,7 @@ bool GLSL::SetUniform(int shader, const char *name, int val) {
 }
 
 bool GLSL::SetUniformv(int shader, const char *name, int count, int *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform1iv(id, count, v);
@@ -237,7 +724,7 @@ bool GLSL::SetUniformv(int shader, const char *name, int count, int *v) {
 }
 
 bool GLSL::SetUniformv(int shader, const char *name, int count, float *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform1fv(id, count, v);
@@ -245,7 +732,7 @@ bool GLSL::SetUniformv(int shader, const char *name, int count, float *v) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, float val) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform1f(id, val);
@@ -253,7 +740,7 @@ bool GLSL::SetUniform(int shader, const char *name, float val) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, vec2 v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform2f(id, v.x, v.y);
@@ -261,7 +748,7 @@ bool GLSL::SetUniform(int shader, const char *name, vec2 v) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, vec3 v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform3f(id, v.x, v.y, v.z);
@@ -269,7 +756,7 @@ bool GLSL::SetUniform(int shader, const char *name, vec3 v) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, vec4 v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform4f(id, v.x, v.y, v.z, v.w);
@@ -277,7 +764,7 @@ bool GLSL::SetUniform(int shader, const char *name, vec4 v) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, vec3 *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform3fv(id, 1, (float *) v);
@@ -285,7 +772,7 @@ bool GLSL::SetUniform(int shader, const char *name, vec3 *v) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, vec4 *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform4fv(id, 1, (float *) v);
@@ -293,7 +780,7 @@ bool GLSL::SetUniform(int shader, const char *name, vec4 *v) {
 }
 
 bool GLSL::SetUniform3(int shader, const char *name, float *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform3fv(id, 1, v);
@@ -301,7 +788,7 @@ bool GLSL::SetUniform3(int shader, const char *name, float *v) {
 }
 
 bool GLSL::SetUniform3v(int shader, const char *name, int count, float *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform3fv(id, count, v);
@@ -309,7 +796,7 @@ bool GLSL::SetUniform3v(int shader, const char *name, int count, float *v) {
 }
 
 bool GLSL::SetUniform4v(int shader, const char *name, int count, float *v) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniform4fv(id, count, v);
@@ -317,17 +804,61 @@ bool GLSL::SetUniform4v(int shader, const char *name, int count, float *v) {
 }
 
 bool GLSL::SetUniform(int shader, const char *name, mat4 m) {
-	GLint id = glGetUniformLocation(shader, name);
+	GLint id = UniformLocation(shader, name);
 	if (id < 0)
 		return Error(name);
 	glUniformMatrix4fv(id, 1, true, (float *) &m[0][0]);
 	return true;
 }
 
+// Uniform Access by Location
+
+bool GLSL::SetUniform(GLint location, int val) {
+	if (location < 0)
+		return false;
+	glUniform1i(location, val);
+	return true;
+}
+
+bool GLSL::SetUniform(GLint location, float val) {
+	if (location < 0)
+		return false;
+	glUniform1f(location, val);
+	return true;
+}
+
+bool GLSL::SetUniform(GLint location, vec2 v) {
+	if (location < 0)
+		return false;
+	glUniform2f(location, v.x, v.y);
+	return true;
+}
+
+bool GLSL::SetUniform(GLint location, vec3 v) {
+	if (location < 0)
+		return false;
+	glUniform3f(location, v.x, v.y, v.z);
+	return true;
+}
+
+bool GLSL::SetUniform(GLint location, vec4 v) {
+	if (location < 0)
+		return false;
+	glUniform4f(location, v.x, v.y, v.z, v.w);
+	return true;
+}
+
+bool GLSL::SetUniform(GLint location, mat4 m) {
+	if (location < 0)
+		return false;
+	glUniformMatrix4fv(location, 1, true, (float *) &m[0][0]);
+	return true;
+}
+
 // Attribute Access
 
 void GLSL::DisableVertexAttribute(int shader, const char *name) {
-	GLint id = glGetAttribLocation(shader, name);
+	GLint id = AttributeLocation(shader, name);
 	if (id >= 0)
 		glDisableVertexAttribArray(id);
 	else
@@ -335,7 +866,7 @@ void GLSL::DisableVertexAttribute(int shader, const char *name) {
 }
 
 int GLSL::EnableVertexAttribute(int shader, const char *name) {
-	GLint id = glGetAttribLocation(shader, name);
+	GLint id = AttributeLocation(shader, name);
 	if (id >= 0)
 		glEnableVertexAttribArray(id);
 	else
@@ -348,3 +879,11 @@ void GLSL::VertexAttribPointer(int shader, const char *name, GLint ncomponents,
 	GLuint id = GLSL::EnableVertexAttribute(shader, name);
     glVertexAttribPointer(id, ncomponents, datatype, normalized, stride, pointer);
 }
+
+void GLSL::VertexAttribPointer(GLint location, GLint ncomponents, GLenum datatype,
+							   GLboolean normalized, GLsizei stride, const GLvoid *pointer) {
+	if (location < 0)
+		return;
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, ncomponents, datatype, normalized, stride, pointer);
+}
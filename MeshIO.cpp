@@ -5,16 +5,131 @@
    ====================================== */
 
 #include "MeshIO.h"
+#include "GLSL.h"
 #include <assert.h>
+#include <ctype.h>
 #include <iostream>
-#include <fstream>
 #include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cfloat>
+#include <list>
+#include <map>
 #include <direct.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define USE_SSE
+#include <emmintrin.h>
+#endif
 
 using std::string;
 using std::vector;
-using std::ios;
-using std::ifstream;
+
+// memory-mapped files
+
+class MappedFile {
+public:
+	const char *data;						// NULL if file can't be opened
+	size_t size;
+	MappedFile(const char *filename) : data(NULL), size(0), released(0) {
+#ifdef _WIN32
+		mapping = NULL;
+		file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+			return;
+		size = (size_t) fileSize.QuadPart;
+		if (!size) {
+			data = "";								// can't map an empty file
+			return;
+		}
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+			data = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		fd = open(filename, O_RDONLY);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) < 0)
+			return;
+		size = (size_t) info.st_size;
+		if (!size) {
+			data = "";
+			return;
+		}
+		void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			madvise(map, size, MADV_SEQUENTIAL);
+			data = (const char *) map;
+		}
+#endif
+	}
+	~MappedFile() {
+#ifdef _WIN32
+		if (data && size)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (data && size)
+			munmap((void *) data, size);
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+	void Release(const char *upTo) {
+		// drop pages before upTo from memory, in whole 64KB blocks; they are re-read if touched
+		size_t n = data && size? (size_t) (upTo-data)&~(size_t) 0xFFFF : 0;
+		if (n <= released)
+			return;
+#ifdef _WIN32
+		VirtualUnlock((void *) (data+released), n-released);	// trims unlocked pages from the working set
+#else
+		madvise((void *) (data+released), n-released, MADV_DONTNEED);
+#endif
+		released = n;
+	}
+private:
+	size_t released;
+#ifdef _WIN32
+	HANDLE file, mapping;
+#else
+	int fd;
+#endif
+};
+
+// threads
+
+template <class Task>
+static void ParallelFor(int n, int nThreads, Task task) {
+	// call task(i) for i = 0 to n-1, distributed over nThreads (including the caller)
+	std::atomic<int> next(0);
+	auto worker = [&]() {
+		for (int i; (i = next++) < n; )
+			task(i);
+	};
+	vector<std::thread> threads;
+	for (int t = 1; t < nThreads && t < n; t++)
+		threads.push_back(std::thread(worker));
+	worker();
+	for (int t = 0; t < (int) threads.size(); t++)
+		threads[t].join();
+}
 
 // center/scale for unit size models
 
@@ -31,376 +146,2848 @@ float GetScaleCenter(vec3 &min, vec3 &max, float scale, vec3 &center) {
 	for (int k = 0; k < 3; k++)
 		if ((max[k]-min[k]) > maxrange)
 			maxrange = max[k]-min[k];
-	return scale*2.f/maxrange;
+	return maxrange > 0? scale*2.f/maxrange : 1;
+}
+
+// bounds and transform kernels: SSE handles a vec3 array four points (three registers) at a
+// time, so lanes hold x y z x, y z x y, z x y z; a VertexSTL is one register whose fourth
+// lane (normal.x) is left unchanged; min and max ignore NaN coordinates
+
+static void Bound(const vec3 *v, int n, vec3 &min, vec3 &max) {
+	// update min, max with n points
+	int i = 0;
+#ifdef USE_SSE
+	if (n >= 4) {
+		const float *f = &v[0].x;
+		__m128 lo[3], hi[3];
+		for (int k = 0; k < 3; k++) {
+			lo[k] = _mm_set1_ps(FLT_MAX);
+			hi[k] = _mm_set1_ps(-FLT_MAX);
+		}
+		for (; i+4 <= n; i += 4, f += 12)
+			for (int k = 0; k < 3; k++) {
+				__m128 q = _mm_loadu_ps(f+4*k);
+				lo[k] = _mm_min_ps(q, lo[k]);
+				hi[k] = _mm_max_ps(q, hi[k]);
+			}
+		vec3 los[4], his[4];
+		for (int k = 0; k < 3; k++) {
+			_mm_storeu_ps(&los[0].x+4*k, lo[k]);
+			_mm_storeu_ps(&his[0].x+4*k, hi[k]);
+		}
+		for (int k = 0; k < 4; k++) {
+			UpdateMinMax(los[k], min, max);
+			UpdateMinMax(his[k], min, max);
+		}
+	}
+#endif
+	for (; i < n; i++)
+		UpdateMinMax(v[i], min, max);
+}
+
+static void Bound(const VertexSTL *v, int n, vec3 &min, vec3 &max) {
+	int i = 0;
+#ifdef USE_SSE
+	if (n) {
+		__m128 lo = _mm_set1_ps(FLT_MAX), hi = _mm_set1_ps(-FLT_MAX);
+		for (; i < n; i++) {
+			__m128 q = _mm_loadu_ps(&v[i].point.x);
+			lo = _mm_min_ps(q, lo);
+			hi = _mm_max_ps(q, hi);
+		}
+		float l[4], h[4];
+		_mm_storeu_ps(l, lo);
+		_mm_storeu_ps(h, hi);
+		UpdateMinMax(vec3(l[0], l[1], l[2]), min, max);
+		UpdateMinMax(vec3(h[0], h[1], h[2]), min, max);
+	}
+#endif
+	for (; i < n; i++)
+		UpdateMinMax(v[i].point, min, max);
+}
+
+static void Transform(vec3 *v, int n, float s, const vec3 &center) {
+	// set each point p to s*(p-center)
+	int i = 0;
+#ifdef USE_SSE
+	float *f = &v[0].x;
+	const float *c = &center.x;
+	__m128 scale = _mm_set1_ps(s);
+	__m128 offset[] = {_mm_setr_ps(c[0], c[1], c[2], c[0]), _mm_setr_ps(c[1], c[2], c[0], c[1]), _mm_setr_ps(c[2], c[0], c[1], c[2])};
+	for (; i+4 <= n; i += 4, f += 12)
+		for (int k = 0; k < 3; k++)
+			_mm_storeu_ps(f+4*k, _mm_mul_ps(scale, _mm_sub_ps(_mm_loadu_ps(f+4*k), offset[k])));
+#endif
+	for (; i < n; i++)
+		v[i] = s*(v[i]-center);
+}
+
+static void Transform(VertexSTL *v, int n, float s, const vec3 &center) {
+	int i = 0;
+#ifdef USE_SSE
+	__m128 scale = _mm_setr_ps(s, s, s, 1), offset = _mm_setr_ps(center.x, center.y, center.z, 0);
+	for (; i < n; i++)
+		_mm_storeu_ps(&v[i].point.x, _mm_mul_ps(scale, _mm_sub_ps(_mm_loadu_ps(&v[i].point.x), offset)));
+#endif
+	for (; i < n; i++)
+		v[i].point = s*(v[i].point-center);
+}
+
+template <class T>
+static float NormalizeBlocks(vector<T> &v, float scale, vec3 *center, int nThreads) {
+	// bound blocks of points concurrently, combine, then transform blocks concurrently
+	const int blockSize = 1 << 16;
+	int n = (int) v.size(), nBlocks = (n+blockSize-1)/blockSize;
+	if (!n)
+		return 1;
+	if (nThreads <= 0)
+		nThreads = std::thread::hardware_concurrency();
+	vector<vec3> mins(nBlocks, vec3(FLT_MAX)), maxs(nBlocks, vec3(-FLT_MAX));
+	ParallelFor(nBlocks, nThreads, [&](int b) {
+		Bound(&v[b*blockSize], std::min(blockSize, n-b*blockSize), mins[b], maxs[b]);
+	});
+	vec3 min(FLT_MAX), max(-FLT_MAX), c;
+	for (int b = 0; b < nBlocks; b++) {
+		UpdateMinMax(mins[b], min, max);
+		UpdateMinMax(maxs[b], min, max);
+	}
+	float s = GetScaleCenter(min, max, scale, c);
+	ParallelFor(nBlocks, nThreads, [&](int b) {
+		Transform(&v[b*blockSize], std::min(blockSize, n-b*blockSize), s, c);
+	});
+	if (center)
+		*center = c;
+	return s;
 }
 
 // normalize STL models
 
 void MinMax(vector<VertexSTL> &points, vec3 &min, vec3 &max) {
-	min.x = min.y = min.z = FLT_MAX;
-	max.x = max.y = max.z = -FLT_MAX;
-	for (int i = 0; i < (int) points.size(); i++)
-		UpdateMinMax(points[i].point, min, max);
+	min = vec3(FLT_MAX);
+	max = vec3(-FLT_MAX);
+	if (points.size())
+		Bound(&points[0], (int) points.size(), min, max);
 }
 
-void Normalize(vector<VertexSTL> &vertices, float scale) {
-	vec3 min, max, center;
-	MinMax(vertices, min, max);
-	float s = GetScaleCenter(min, max, scale, center);
-	for (int i = 0; i < (int) vertices.size(); i++) {
-		vec3 &v = vertices[i].point;
-		v = s*(v-center);
-	}
+float Normalize(vector<VertexSTL> &vertices, float scale, vec3 *center, int nThreads) {
+	return NormalizeBlocks(vertices, scale, center, nThreads);
 }
 
 // normalize vec3 models
 
 void MinMax(vector<vec3> &points, vec3 &min, vec3 &max) {
-	min[0] = min[1] = min[2] = FLT_MAX;
-	max[0] = max[1] = max[2] = -FLT_MAX;
-	for (int i = 0; i < (int) points.size(); i++) {
-		vec3 &v = points[i];
+	min = vec3(FLT_MAX);
+	max = vec3(-FLT_MAX);
+	if (points.size())
+		Bound(&points[0], (int) points.size(), min, max);
+}
+
+float Normalize(vector<vec3> &points, float scale, vec3 *center, int nThreads) {
+	return NormalizeBlocks(points, scale, center, nThreads);
+}
+
+// vertex normals
+
+static void AccumulateNormals(const vec3 *points, const int3 *triangles, int nTriangles, vec3 *normals) {
+	// add the unit normal of each triangle to its three vertex normals; a degenerate triangle adds nothing
+	int i = 0;
+#ifdef USE_SSE
+	// four triangles at a time: gather corners into x, y, z lanes, then cross and normalize together
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1);
+	for (; i+4 <= nTriangles; i += 4) {
+		const int3 *t = triangles+i;
+		__m128 c[3][3];									// [corner][axis]
 		for (int k = 0; k < 3; k++) {
-			if (v[k] < min[k]) min[k] = v[k];
-			if (v[k] > max[k]) max[k] = v[k];
+			const vec3 &q0 = points[(&t[0].i1)[k]], &q1 = points[(&t[1].i1)[k]], &q2 = points[(&t[2].i1)[k]], &q3 = points[(&t[3].i1)[k]];
+			c[k][0] = _mm_setr_ps(q0.x, q1.x, q2.x, q3.x);
+			c[k][1] = _mm_setr_ps(q0.y, q1.y, q2.y, q3.y);
+			c[k][2] = _mm_setr_ps(q0.z, q1.z, q2.z, q3.z);
+		}
+		__m128 ax = _mm_sub_ps(c[1][0], c[0][0]), ay = _mm_sub_ps(c[1][1], c[0][1]), az = _mm_sub_ps(c[1][2], c[0][2]);
+		__m128 bx = _mm_sub_ps(c[2][0], c[1][0]), by = _mm_sub_ps(c[2][1], c[1][1]), bz = _mm_sub_ps(c[2][2], c[1][2]);
+		__m128 nx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+		__m128 ny = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+		__m128 nz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+		__m128 r = _mm_and_ps(_mm_div_ps(one, _mm_sqrt_ps(d)), _mm_cmpgt_ps(d, zero));
+		float n[3][4];
+		_mm_storeu_ps(n[0], _mm_mul_ps(nx, r));
+		_mm_storeu_ps(n[1], _mm_mul_ps(ny, r));
+		_mm_storeu_ps(n[2], _mm_mul_ps(nz, r));
+		for (int j = 0; j < 4; j++) {
+			vec3 v(n[0][j], n[1][j], n[2][j]);
+			normals[t[j].i1] += v;
+			normals[t[j].i2] += v;
+			normals[t[j].i3] += v;
+		}
+	}
+#endif
+	for (; i < nTriangles; i++) {
+		const int3 &t = triangles[i];
+		const vec3 &p1 = points[t.i1], &p2 = points[t.i2], &p3 = points[t.i3];
+		vec3 n(cross(p2-p1, p3-p2));
+		float d = dot(n, n);
+		if (d > 0) {
+			n *= 1/std::sqrt(d);
+			normals[t.i1] += n;
+			normals[t.i2] += n;
+			normals[t.i3] += n;
 		}
 	}
 }
 
-void Normalize(vector<vec3> &points, float scale) {
-	vec3 min, max;
-	MinMax(points, min, max);
-	vec3 center(.5f*(min[0]+max[0]), .5f*(min[1]+max[1]), .5f*(min[2]+max[2]));
-	float maxrange = 0;
-	for (int k = 0; k < 3; k++)
-		if ((max[k]-min[k]) > maxrange)
-			maxrange = max[k]-min[k];
-	float s = scale*2.f/maxrange;
-	for (int i = 0; i < (int) points.size(); i++) {
-		vec3 &v = points[i];
-		for (int k = 0; k < 3; k++)
-			v[k] = s*(v[k]-center[k]);
+static void NormalizeVectors(vec3 *v, int n) {
+	// set to unit length, leaving zero vectors zero
+	for (int i = 0; i < n; i++) {
+		float d = dot(v[i], v[i]);
+		if (d > 0)
+			v[i] *= 1/std::sqrt(d);
+	}
+}
+
+void SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals, int nThreads) {
+	// each task accumulates a block of triangles into its own buffer (the first into normals),
+	// so threads never write the same vertex; buffers are then summed over blocks of vertices
+	const int minTriangles = 1 << 16, blockSize = 1 << 14;
+	int nverts = (int) points.size(), ntris = (int) triangles.size();
+	if (nThreads <= 0)
+		nThreads = std::thread::hardware_concurrency();
+	if (nThreads > ntris/minTriangles)
+		nThreads = ntris/minTriangles > 1? ntris/minTriangles : 1;
+	normals.assign(nverts, vec3(0));
+	if (!nverts || !ntris)
+		return;
+	if (nThreads == 1) {
+		AccumulateNormals(&points[0], &triangles[0], ntris, &normals[0]);
+		NormalizeVectors(&normals[0], nverts);
+		return;
 	}
+	vector<vector<vec3> > sums(nThreads-1);
+	ParallelFor(nThreads, nThreads, [&](int b) {
+		int begin = (int) ((long long) ntris*b/nThreads), end = (int) ((long long) ntris*(b+1)/nThreads);
+		vec3 *sum = &normals[0];
+		if (b) {
+			sums[b-1].assign(nverts, vec3(0));
+			sum = &sums[b-1][0];
+		}
+		AccumulateNormals(&points[0], &triangles[begin], end-begin, sum);
+	});
+	ParallelFor((nverts+blockSize-1)/blockSize, nThreads, [&](int b) {
+		int begin = b*blockSize, end = begin+blockSize < nverts? begin+blockSize : nverts;
+		for (int s = 0; s < nThreads-1; s++)
+			for (int i = begin; i < end; i++)
+				normals[i] += sums[s][i];
+		NormalizeVectors(&normals[begin], end-begin);
+	});
+}
+
+static float CornerAngle(const vec3 &p, const vec3 &a, const vec3 &b) {
+	// angle at p of triangle p, a, b (0 if degenerate)
+	vec3 u(a-p), v(b-p);
+	float d = std::sqrt(dot(u, u)*dot(v, v));
+	if (!(d > 0))
+		return 0;
+	float c = dot(u, v)/d;
+	return acos(c < -1? -1 : c > 1? 1 : c);
 }
 
-void SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals) {
-	// size normals array and initialize to zero
-	int nverts = (int) points.size();
-	normals.resize(nverts, vec3(0));
-	// accumulate each triangle normal into its three vertex normals
-	for (int i = 0; i < (int) triangles.size(); i++) {
+static bool SharesEdge(const int3 &t1, const int3 &t2, int vid) {
+	// do triangles that both contain vid also share another vertex?
+	const int *a = &t1.i1, *b = &t2.i1;
+	for (int i = 0; i < 3; i++)
+		if (a[i] != vid && (a[i] == b[0] || a[i] == b[1] || a[i] == b[2]))
+			return true;
+	return false;
+}
+
+static int FindRoot(vector<int> &parents, int i) {
+	while (parents[i] != i)
+		i = parents[i] = parents[parents[i]];
+	return i;
+}
+
+void SetVertexNormals(vector<vec3>	&points,
+					  vector<int3>	&triangles,
+					  vector<vec3>	&normals,
+					  NormalWeight	weight,
+					  float			creaseAngle,
+					  vector<int>	*copiedFrom) {
+	int nverts = (int) points.size(), ntris = (int) triangles.size();
+	if (copiedFrom)
+		copiedFrom->resize(0);
+	if (weight == NW_Uniform && creaseAngle >= 180) {
+		SetVertexNormals(points, triangles, normals);
+		return;
+	}
+	// unit triangle normals and per-corner weights
+	vector<vec3> faceNormals(ntris);
+	vector<float> weights(3*ntris, 1);
+	for (int i = 0; i < ntris; i++) {
 		int3 &t = triangles[i];
-		vec3 &p1 = points[t.i1], &p2 = points[t.i2], &p3 = points[t.i3];
-		vec3 a(p2-p1), b(p3-p2), n(normalize(cross(a, b)));
-		normals[t.i1] += n;
-		normals[t.i2] += n;
-		normals[t.i3] += n;
+		vec3 &p1 = points[t.i1], &p2 = points[t.i2], &p3 = points[t.i3], n(cross(p2-p1, p3-p2));
+		float len = length(n);
+		faceNormals[i] = len > 0? n/len : vec3(0);
+		float *w = &weights[3*i];
+		if (weight == NW_Area)
+			w[0] = w[1] = w[2] = len;					// twice the area
+		if (weight == NW_Angle) {
+			w[0] = CornerAngle(p1, p2, p3);
+			w[1] = CornerAngle(p2, p3, p1);
+			w[2] = CornerAngle(p3, p1, p2);
+		}
+	}
+	normals.assign(nverts, vec3(0));
+	if (creaseAngle >= 180) {
+		for (int c = 0; c < 3*ntris; c++)
+			normals[(&triangles[c/3].i1)[c%3]] += weights[c]*faceNormals[c/3];
+		NormalizeVectors(&normals[0], nverts);
+		return;
 	}
-	// set to unit length
-	for (int i = 0; i < nverts; i++)
-		normals[i] = normalize(normals[i]);
+	// list corners by vertex (corner c is vertex c%3 of triangle c/3)
+	vector<int> firstCorners(nverts+1, 0), corners(3*ntris), cornerIds(3*ntris);
+	for (int c = 0; c < 3*ntris; c++)
+		firstCorners[(&triangles[c/3].i1)[c%3]+1]++;
+	for (int v = 0; v < nverts; v++)
+		firstCorners[v+1] += firstCorners[v];
+	vector<int> nextCorners(firstCorners.begin(), firstCorners.end()-1);
+	for (int c = 0; c < 3*ntris; c++)
+		corners[nextCorners[(&triangles[c/3].i1)[c%3]]++] = c;
+	// around each vertex, join corners whose triangles meet at an edge no sharper than
+	// creaseAngle; the first group keeps the vertex, each other group gets a copy
+	float minDot = cos(creaseAngle*3.1415926535f/180);
+	vector<int> parents, groupIds;
+	for (int v = 0; v < nverts; v++) {
+		int *vCorners = &corners[0]+firstCorners[v], n = firstCorners[v+1]-firstCorners[v];
+		parents.resize(n);
+		groupIds.assign(n, -1);
+		for (int i = 0; i < n; i++)
+			parents[i] = i;
+		for (int i = 0; i < n; i++)
+			for (int j = i+1; j < n; j++) {
+				int ti = vCorners[i]/3, tj = vCorners[j]/3;
+				vec3 &ni = faceNormals[ti], &nj = faceNormals[tj];
+				bool degenerate = dot(ni, ni) == 0 || dot(nj, nj) == 0;
+				if (SharesEdge(triangles[ti], triangles[tj], v) && (degenerate || dot(ni, nj) >= minDot))
+					parents[FindRoot(parents, i)] = FindRoot(parents, j);
+			}
+		bool kept = false;
+		for (int i = 0; i < n; i++) {
+			int root = FindRoot(parents, i), c = vCorners[i];
+			if (groupIds[root] < 0) {
+				groupIds[root] = kept? (int) points.size() : v;
+				if (kept) {
+					points.push_back(points[v]);
+					normals.push_back(vec3(0));
+					if (copiedFrom)
+						copiedFrom->push_back(v);
+				}
+				kept = true;
+			}
+			cornerIds[c] = groupIds[root];
+			normals[cornerIds[c]] += weights[c]*faceNormals[c/3];
+		}
+	}
+	for (int c = 0; c < 3*ntris; c++)
+		(&triangles[c/3].i1)[c%3] = cornerIds[c];
+	NormalizeVectors(&normals[0], (int) normals.size());
 }
 
-// ASCII support
 
-bool ReadWord(char* &ptr, char *word, int charLimit) {
-	ptr += strspn(ptr, " \t");					// skip white space
-	int nChars = strcspn(ptr, " \t");	        // get # non-white-space characters
-	if (!nChars)
-		return false;					        // no non-space characters
-	int nRead = charLimit-1 < nChars? charLimit-1 : nChars;
-	strncpy(word, ptr, nRead);
-	word[nRead] = 0;							// strncpy does not null terminate
-	ptr += nChars;
+// binary mesh cache
+
+// a parsed mesh is saved next to its source as <source>.meshbin and reloaded from
+// there while the source's size and modification time are unchanged; the file is a
+// header followed by the arrays in header order, all little-endian; the cache is off
+// unless enabled, and a cache whose indices fall outside its arrays is ignored, as
+// the file may have been written by another program or damaged
+
+static bool useMeshCache = false;
+
+void UseMeshCache(bool use) { useMeshCache = use; }
+
+static bool FileStamp(const char *filename, unsigned long long &size, long long &time) {
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(filename, &info) != 0)
+		return false;
+#else
+	struct stat info;
+	if (stat(filename, &info) != 0)
+		return false;
+#endif
+	size = (unsigned long long) info.st_size;
+	time = (long long) info.st_mtime;
+	return true;
+}
+
+static bool LittleEndian() {
+	unsigned int one = 1;
+	return *(unsigned char *) &one == 1;
+}
+
+template <class T>
+static void Append(vector<T> &to, vector<T> &from) {
+	if (to.empty())
+		to.swap(from);
+	else
+		to.insert(to.end(), from.begin(), from.end());
+}
+
+class MeshCache {
+public:
+	enum Source {C_Obj = 1, C_Stl = 2};
+	vector<vec3> points, normals;
+	vector<vec2> textures;
+	vector<int3> triangles;
+	vector<int> groups;
+	vector<int> flipped;				// OBJ triangles reversed to agree with their normal
+	vector<VertexSTL> vertices;			// STL triangle soup
+	bool Read(const char *filename, Source source) {
+		// read cache for filename; return false if absent, stale, or malformed
+		Header h, expect;
+		string cacheName = string(filename)+".meshbin";
+		if (!useMeshCache || !LittleEndian() || !Stamp(filename, source, expect))
+			return false;
+		MappedFile in(cacheName.c_str());
+		if (!in.data || in.size < sizeof(Header))
+			return false;
+		memcpy(&h, in.data, sizeof(Header));
+		if (memcmp(h.magic, expect.magic, sizeof(h.magic)) || h.version != expect.version || h.source != expect.source ||
+			h.sourceSize != expect.sourceSize || h.sourceTime != expect.sourceTime || in.size != sizeof(Header)+h.DataSize())
+			return false;
+		const char *p = in.data+sizeof(Header);
+		Get(p, points, h.nPoints);
+		Get(p, normals, h.nNormals);
+		Get(p, textures, h.nTextures);
+		Get(p, triangles, h.nTriangles);
+		Get(p, groups, h.nGroups);
+		Get(p, flipped, h.nFlipped);
+		Get(p, vertices, h.nVertices);
+		if (!Valid()) {
+			*this = MeshCache();				// the caller parses into these arrays instead
+			return false;
+		}
+		return true;
+	}
+	void Write(const char *filename, Source source) {
+		// save arrays; a failed write leaves no cache
+		Header h;
+		string cacheName = string(filename)+".meshbin";
+		if (!useMeshCache || !LittleEndian() || !Stamp(filename, source, h))
+			return;
+		h.nPoints = points.size();
+		h.nNormals = normals.size();
+		h.nTextures = textures.size();
+		h.nTriangles = triangles.size();
+		h.nGroups = groups.size();
+		h.nFlipped = flipped.size();
+		h.nVertices = vertices.size();
+		FILE *out = fopen(cacheName.c_str(), "wb");
+		if (!out)
+			return;
+		bool ok = fwrite(&h, sizeof(Header), 1, out) == 1 &&
+				  Put(out, points) && Put(out, normals) && Put(out, textures) && Put(out, triangles) &&
+				  Put(out, groups) && Put(out, flipped) && Put(out, vertices);
+		if (fclose(out) != 0 || !ok)
+			remove(cacheName.c_str());
+	}
+private:
+	struct Header {
+		char magic[8];
+		unsigned int version, source;
+		unsigned long long sourceSize;
+		long long sourceTime;
+		unsigned int nPoints, nNormals, nTextures, nTriangles, nGroups, nFlipped, nVertices, pad;
+		Header() : version(1), source(0), sourceSize(0), sourceTime(0),
+			nPoints(0), nNormals(0), nTextures(0), nTriangles(0), nGroups(0), nFlipped(0), nVertices(0), pad(0) {
+			memcpy(magic, "MESHBIN", 8);
+		}
+		size_t DataSize() {
+			return (size_t) nPoints*sizeof(vec3)+(size_t) nNormals*sizeof(vec3)+(size_t) nTextures*sizeof(vec2)+
+				   (size_t) nTriangles*sizeof(int3)+(size_t) nGroups*sizeof(int)+(size_t) nFlipped*sizeof(int)+
+				   (size_t) nVertices*sizeof(VertexSTL);
+		}
+	};
+	bool Valid() {
+		// every triangle index names a point, every flipped index a triangle, and
+		// groups, if present, are one per triangle; STL vertices are whole triangles
+		int nPoints = points.size(), nTriangles = triangles.size();
+		if ((!groups.empty() && (int) groups.size() != nTriangles) || vertices.size()%3)
+			return false;
+		for (int i = 0; i < nTriangles; i++) {
+			int3 &t = triangles[i];
+			if ((unsigned) t.i1 >= (unsigned) nPoints || (unsigned) t.i2 >= (unsigned) nPoints || (unsigned) t.i3 >= (unsigned) nPoints)
+				return false;
+		}
+		for (int i = 0; i < (int) flipped.size(); i++)
+			if ((unsigned) flipped[i] >= (unsigned) nTriangles)
+				return false;
 		return true;
+	}
+	static bool Stamp(const char *filename, Source source, Header &h) {
+		h.source = source;
+		return FileStamp(filename, h.sourceSize, h.sourceTime);
+	}
+	template <class T>
+	static void Get(const char *&p, vector<T> &v, unsigned int n) {
+		// copied as bytes: vec3, vec2 and VertexSTL are plain floats but have constructors
+		v.resize(n);
+		if (n)
+			memcpy(reinterpret_cast<char *>(v.data()), p, n*sizeof(T));
+		p += n*sizeof(T);
+	}
+	template <class T>
+	static bool Put(FILE *out, vector<T> &v) {
+		return v.empty() || fwrite(v.data(), sizeof(T), v.size(), out) == v.size();
+	}
+};
+
+// ASCII support
+
+// tokenizer for memory-mapped text: unlike the C library, these never read past end
+// and never need a null terminator; a token ends at a blank or at the end of line
+
+static inline bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline bool IsSpace(char c) { return IsBlank(c) || c == '\n'; }
+
+static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline const char *SkipBlanks(const char *p, const char *end) {
+	while (p < end && IsBlank(*p))
+		p++;
+	return p;
+}
+
+static inline const char *SkipToken(const char *p, const char *end) {
+	while (p < end && !IsSpace(*p))
+		p++;
+	return p;
+}
+
+static inline const char *SkipLine(const char *p, const char *end) {
+	p = (const char *) memchr(p, '\n', end-p);
+	return p? p+1 : end;
+}
+
+static inline const char *IntDigits(const char *p, const char *end) {
+	// first digit of a signed integer at p, or NULL if none
+	const char *s = p < end && (*p == '-' || *p == '+')? p+1 : p;
+	return s < end && IsDigit(*s)? s : NULL;
+}
+
+static bool ReadInt(const char *&p, const char *end, int &i) {
+	// as atoi, but set p past the digits; return false if no digits or out of int range
+	const char *s = IntDigits(p, end);
+	if (!s)
+		return false;
+	bool negative = *p == '-';
+	long long n = 0, max = negative? -(long long) INT_MIN : INT_MAX;
+	for (; s < end && IsDigit(*s); s++)
+		if ((n = 10*n+(*s-'0')) > max)
+			return false;
+	i = (int) (negative? -n : n);
+	p = s;
+	return true;
+}
+
+static bool ReadFloatSlow(const char *&p, const char *end, float &f) {
+	// copy token for strtof (handles inf, nan, hex, and very long mantissas)
+	char buf[100], *bufEnd;
+	int n = 0;
+	for (const char *s = p; s < end && !IsSpace(*s) && n < 99; s++)
+		buf[n++] = *s;
+	buf[n] = 0;
+	f = strtof(buf, &bufEnd);
+	if (bufEnd == buf)
+		return false;
+	p += bufEnd-buf;
+	return true;
+}
+
+static bool ReadFloat(const char *&p, const char *end, float &f) {
+	// equivalent to sscanf %g for the decimal forms written by modelers; the mantissa
+	// is accumulated as an integer and scaled once by an exact power of ten, which
+	// is correctly rounded whenever the mantissa has at most 15 significant digits
+	static const double powersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+										1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+										1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+	p = SkipBlanks(p, end);
+	const char *s = p;
+	bool negative = s < end && *s == '-';
+	if (s < end && (*s == '-' || *s == '+'))
+		s++;
+	unsigned long long mantissa = 0;
+	int nDigits = 0, nSignificant = 0, exponent = 0;
+	for (; s < end && IsDigit(*s); s++, nDigits++)
+		if (nSignificant < 19) {
+			mantissa = 10*mantissa+(*s-'0');
+			nSignificant += mantissa != 0;
+		}
+		else
+			exponent++;
+	if (s < end && *s == '.')
+		for (s++; s < end && IsDigit(*s); s++, nDigits++)
+			if (nSignificant < 19) {
+				mantissa = 10*mantissa+(*s-'0');
+				nSignificant += mantissa != 0;
+				exponent--;
+			}
+	if (!nDigits || (s < end && (*s == 'x' || *s == 'X')))
+		return ReadFloatSlow(p, end, f);
+	if (s < end && (*s == 'e' || *s == 'E')) {
+		const char *e = s+1;
+		int exp10;
+		if (ReadInt(e, end, exp10)) {
+			exponent += exp10;
+			s = e;
+		}
+		else if (IntDigits(e, end))
+			return ReadFloatSlow(p, end, f);		// exponent beyond int: strtof gives inf or 0
+	}
+	if (nSignificant > 15 || exponent < -22 || exponent > 22)
+		return ReadFloatSlow(p, end, f);
+	double d = (double) mantissa;
+	d = exponent < 0? d/powersOf10[-exponent] : d*powersOf10[exponent];
+	f = (float) (negative? -d : d);
+	p = s;
+	return true;
+}
+
+static bool ReadFloats(const char *&p, const char *end, float *f, int n) {
+	for (int i = 0; i < n; i++)
+		if (!ReadFloat(p, end, f[i]))
+			return false;
+	return true;
 }
 
 // STL
 
-int ReadSTL(char *filename, vector<VertexSTL> &vertices) {
-	// the facet normal should point outwards from the solid object; if this is zero,
-	// most software will calculate a normal from the ordered triangle vertices using the right-hand rule
-    class Helper {
-    public:
-        bool status;
-		int nTriangles;
-		vector<VertexSTL> *verts;
-        vector<string> vSpecs;                              // ASCII only
-        Helper(char *filename, vector<VertexSTL> *verts) : verts(verts) {
-			char line[1000], word[1000], *ptr = line;
-			ifstream inText(filename, ios::in);				// text default mode
-			inText.getline(line, 10);
-			bool ascii = ReadWord(ptr, word, 10) && !_stricmp(word, "solid");
-			ascii = false; // hmm!
-			if (ascii)
-				status = ReadASCII(inText);
-			inText.close();
-			if (!ascii) {
-				FILE *inBinary = fopen(filename, "rb");		// inText.setmode(ios::binary) fails
-				if (inBinary) {
-					nTriangles = 0;
-					status = ReadBinary(inBinary);
-					fclose(inBinary);
-				}
-				else
-					status = false;
+static inline void SetFacet(VertexSTL *out, const vec3 &n, const vec3 &v0, const vec3 &v1, const vec3 &v2) {
+	// the facet normal should point outwards from the solid object; reverse a triangle
+	// whose right-hand-rule normal disagrees (a zero facet normal keeps the given order)
+	bool flip = dot(cross(v1-v0, v2-v1), n) < 0;
+	out[0].point = flip? v2 : v0;
+	out[1].point = v1;
+	out[2].point = flip? v0 : v2;
+	out[0].normal = out[1].normal = out[2].normal = n;
+}
+
+static const int STLHeaderSize = 84, STLRecordSize = 50;
+
+static bool IsBinarySTL(const char *data, size_t size) {
+	// binary unless the file begins with 'solid'; some exporters write 'solid' into
+	// the binary header as well, so a file whose size agrees with its triangle count is binary
+	const char *end = data+size, *word = data;
+	while (word < end && IsSpace(*word))
+		word++;
+	const char *wordEnd = SkipToken(word, end);
+	if (wordEnd-word != 5 || _strnicmp(word, "solid", 5))
+		return true;
+	unsigned int nTriangles;
+	if (size < STLHeaderSize)
+		return false;
+	memcpy(&nTriangles, data+80, 4);
+	return size == STLHeaderSize+STLRecordSize*(unsigned long long) nTriangles;
+}
+
+static int ParseAsciiSTL(const char *&ptr, const char *data, const char *end, vector<VertexSTL> &vertices, int maxTriangles) {
+	//	solid name
+	//	  facet normal nx ny nz
+	//	    outer loop
+	//	      vertex x y z			(three, or more for a planar polygon, which is fanned)
+	//	    endloop
+	//	  endfacet
+	//	endsolid name
+	// keywords are case-insensitive and a file may hold several solids
+	// parse from ptr until end of file or until at least maxTriangles have been added,
+	// leaving ptr after the last facet; return # triangles added, or -1 if malformed
+	vector<vec3> loop;
+	vec3 n;
+	int nTriangles = 0;
+	while (nTriangles < maxTriangles) {
+		while (ptr < end && IsSpace(*ptr))
+			ptr++;
+		if (ptr >= end)
+			break;
+		const char *word = ptr;
+		ptr = SkipToken(ptr, end);
+		int nChars = ptr-word;
+		bool ok = true;
+		if ((nChars == 5 && !_strnicmp(word, "solid", 5)) || (nChars == 8 && !_strnicmp(word, "endsolid", 8)))
+			ptr = SkipLine(ptr, end);						// name may contain blanks
+		else if (nChars == 5 && !_strnicmp(word, "facet", 5)) {
+			const char *normal = SkipBlanks(ptr, end);
+			ptr = SkipToken(normal, end);
+			ok = ptr-normal == 6 && !_strnicmp(normal, "normal", 6) && ReadFloats(ptr, end, &n.x, 3);
+			loop.resize(0);
+		}
+		else if (nChars == 6 && !_strnicmp(word, "vertex", 6)) {
+			vec3 v;
+			ok = ReadFloats(ptr, end, &v.x, 3);
+			loop.push_back(v);
+		}
+		else if (nChars == 8 && !_strnicmp(word, "endfacet", 8)) {
+			ok = loop.size() >= 3;
+			if (ok) {
+				size_t start = vertices.size();
+				vertices.resize(start+3*(loop.size()-2));
+				for (int i = 1; i < (int) loop.size()-1; i++, nTriangles++)
+					SetFacet(&vertices[start+3*(i-1)], n, loop[0], loop[i], loop[i+1]);
 			}
-        }
-        bool ReadASCII(ifstream &in) {
-			printf("can't read ASCII STL - tell prof\n");
-			return true;
-        }
-        bool ReadBinary(FILE *in) {
-                  // # bytes      use                  significance
-                  // -------      ---                  ------------
-                  //      80      header               none
-                  //       4      unsigned long int    number of triangles
-                  //      12      3 floats             triangle normal
-                  //      12      3 floats             x,y,z for vertex 1
-                  //      12      3 floats             vertex 2
-                  //      12      3 floats             vertex 3
-                  //       2      unsigned short int   attribute (0)
-                  // endianness is assumed to be little endian
-            // in.setmode(ios::binary); doc says setmode good, but compiler says not so
-			// sizeof(bool)=1, sizeof(char)=1, sizeof(short)=2, sizeof(int)=4, sizeof(float)=4
-            char buf[81];
-            unsigned int nTriangle = 0;//, vid1, vid2, vid3;
-            if (fread(buf, 1, 80, in) != 80) // header
-                return false;
-            if (fread(&nTriangles, sizeof(int), 1, in) != 1)
-                return false;
-            while (!feof(in)) {
-				vec3 v[3], n;
-                if (nTriangle == nTriangles)
-                    break;
-                if (nTriangles > 5000 && nTriangle && nTriangle%1000 == 0)
-					printf("\rread %i/%i triangles", nTriangle, nTriangles);
-                if (fread(&n.x, sizeof(float), 3, in) != 3)
-                    printf("\ncan't read triangle %d normal\n", nTriangle);
-				for (int k = 0; k < 3; k++)
-					if (fread(&v[k].x, sizeof(float), 3, in) != 3)
-                        printf("\ncan't read vid %d\n", verts->size());
-				vec3 a(v[1]-v[0]), b(v[2]-v[1]);
-				vec3 ntmp = cross(a, b);
-				if (dot(ntmp, n) < 0) {
-					vec3 vtmp = v[0];
-					v[0] = v[2];
-					v[2] = vtmp;
-				}
-				for (int k = 0; k < 3; k++)
-					verts->push_back(VertexSTL((float *) &v[k].x, (float *) &n.x));
-				unsigned short attribute;
-			    if (fread(&attribute, sizeof(short), 1, in) != 1)
-				    printf("\ncan't read attribute\n");
-				nTriangle++;
-            }
-			printf("\r\t\t\t\t\t\t\r");
-            return true;
-        }
-    };
-    Helper h(filename, &vertices);
-    return h.nTriangles;
-} // end ReadSTL
+		}
+		else if (nChars == 5 && !_strnicmp(word, "outer", 5))
+			ptr = SkipLine(ptr, end);						// 'outer loop'
+		else
+			ok = nChars == 7 && !_strnicmp(word, "endloop", 7);
+		if (!ok) {
+			int line = 1;
+			for (const char *p = data; p < word; p++)
+				line += *p == '\n';
+			printf("bad ASCII STL at line %i\n", line);
+			return -1;
+		}
+	}
+	return nTriangles;
+}
+
+static int BinarySTLCount(const char *data, size_t size) {
+	// # bytes   use                  significance
+	// -------   ---                  ------------
+	//      80   header               none
+	//       4   unsigned int         number of triangles
+	//      12   3 floats             triangle normal
+	//      36   9 floats             x,y,z for vertices 1, 2, 3
+	//       2   unsigned short int   attribute (0)
+	// return # complete triangle records, or -1 if no header
+	if (size < STLHeaderSize)
+		return -1;
+	unsigned int nTriangles, nRecords = (unsigned int) ((size-STLHeaderSize)/STLRecordSize);
+	memcpy(&nTriangles, data+80, 4);
+	if (nTriangles > nRecords) {
+		printf("STL file has %u of %u triangles\n", nRecords, nTriangles);
+		nTriangles = nRecords;
+	}
+	return (int) nTriangles;
+}
+
+static void DecodeBinarySTL(const char *record, int nTriangles, VertexSTL *out) {
+	// records are decoded in place from the mapped file; endianness is assumed to be little endian
+	for (int i = 0; i < nTriangles; i++, record += STLRecordSize, out += 3) {
+		float f[12];
+		memcpy(f, record, sizeof(f));
+		SetFacet(out, vec3(f[0], f[1], f[2]), vec3(f[3], f[4], f[5]), vec3(f[6], f[7], f[8]), vec3(f[9], f[10], f[11]));
+	}
+}
+
+int ReadSTL(char *filename, vector<VertexSTL> &vertices) {
+	MeshCache cache;
+	if (cache.Read(filename, MeshCache::C_Stl)) {
+		int nTriangles = cache.vertices.size()/3;
+		Append(vertices, cache.vertices);
+		return nTriangles;
+	}
+	MappedFile in(filename);
+	if (!in.data) {
+		printf("can't open %s\n", filename);
+		return 0;
+	}
+	int nTriangles;
+	if (IsBinarySTL(in.data, in.size)) {
+		nTriangles = BinarySTLCount(in.data, in.size);
+		if (nTriangles > 0) {
+			cache.vertices.resize(3*(size_t) nTriangles);
+			DecodeBinarySTL(in.data+STLHeaderSize, nTriangles, &cache.vertices[0]);
+		}
+	}
+	else {
+		const char *ptr = in.data;
+		cache.vertices.reserve(3*(in.size/256));		// a facet is about 250 characters
+		nTriangles = ParseAsciiSTL(ptr, in.data, in.data+in.size, cache.vertices, INT_MAX);
+	}
+	if (nTriangles <= 0)
+		return 0;
+	cache.Write(filename, MeshCache::C_Stl);
+	Append(vertices, cache.vertices);
+	return nTriangles;
+}
+
+static unsigned int HashInt3(const int3 &k) {
+	unsigned int h = (unsigned int) k.i1*0x9E3779B1u ^ (unsigned int) k.i2*0x85EBCA77u ^ (unsigned int) k.i3*0xC2B2AE3Du;
+	return h^(h >> 15);
+}
+
+class PointWelder {
+	// spatial hash of points binned into cubic cells of side tolerance; a new point
+	// is matched against points in its own and the 26 neighboring cells
+	// (with zero tolerance the cell is the point's bit pattern, so only identical points match)
+public:
+	PointWelder(vector<vec3> &points, float tolerance) : points(points), tolerance(tolerance), nEntries(0) { }
+	void Reserve(int nPoints) {
+		int capacity = 16;
+		while (capacity < 2*nPoints)
+			capacity *= 2;
+		entries.assign(capacity, Entry());
+	}
+	int Insert(const vec3 &p) {
+		// return id of a point within tolerance of p, else append p and return its id
+		int3 cell = Cell(p);
+		if (tolerance > 0) {
+			for (int i = -1; i <= 1; i++)
+				for (int j = -1; j <= 1; j++)
+					for (int k = -1; k <= 1; k++) {
+						int id = Find(int3(cell.i1+i, cell.i2+j, cell.i3+k), p);
+						if (id >= 0)
+							return id;
+					}
+		}
+		else {
+			int id = Find(cell, p);
+			if (id >= 0)
+				return id;
+		}
+		if (2*(nEntries+1) > (int) entries.size())
+			Grow();
+		int id = points.size();
+		points.push_back(p);
+		Put(Entry(cell, id));
+		return id;
+	}
+private:
+	struct Entry {
+		int3 cell;
+		int id;							// -1 if empty
+		Entry() : id(-1) { }
+		Entry(const int3 &cell, int id) : cell(cell), id(id) { }
+	};
+	vector<vec3> &points;
+	vector<Entry> entries;				// size is a power of two, at most half full
+	float tolerance;
+	int nEntries;
+	int3 Cell(const vec3 &p) {
+		if (tolerance > 0)
+			return int3((int) floor(p.x/tolerance), (int) floor(p.y/tolerance), (int) floor(p.z/tolerance));
+		vec3 q(p.x+0.f, p.y+0.f, p.z+0.f);	// -0 becomes +0
+		int bits[3];
+		memcpy(bits, &q.x, sizeof(bits));
+		return int3(bits[0], bits[1], bits[2]);
+	}
+	int Find(const int3 &cell, const vec3 &p) {
+		if (entries.empty())
+			return -1;
+		for (unsigned int mask = entries.size()-1, i = HashInt3(cell)&mask; entries[i].id >= 0; i = (i+1)&mask) {
+			const Entry &e = entries[i];
+			if (e.cell == cell && (!tolerance || length(points[e.id]-p) <= tolerance))
+				return e.id;
+		}
+		return -1;
+	}
+	void Put(const Entry &e) {
+		unsigned int mask = entries.size()-1, i = HashInt3(e.cell)&mask;
+		while (entries[i].id >= 0)
+			i = (i+1)&mask;
+		entries[i] = e;
+		nEntries++;
+	}
+	void Grow() {
+		vector<Entry> old(2*(entries.size() > 8? entries.size() : 8));
+		old.swap(entries);
+		nEntries = 0;
+		for (int i = 0; i < (int) old.size(); i++)
+			if (old[i].id >= 0)
+				Put(old[i]);
+	}
+};
+
+int ReadSTL(char *filename, vector<vec3> &points, vector<int3> &triangles, float tolerance) {
+	vector<VertexSTL> vertices;
+	int nTriangles = ReadSTL(filename, vertices), nStart = triangles.size();
+	PointWelder welder(points, tolerance);
+	welder.Reserve(vertices.size()/2);		// closed meshes have about half as many points as triangles
+	points.reserve(points.size()+vertices.size()/6);
+	triangles.reserve(triangles.size()+nTriangles);
+	for (int i = 0; i < nTriangles; i++) {
+		VertexSTL *v = &vertices[3*i];
+		int3 t(welder.Insert(v[0].point), welder.Insert(v[1].point), welder.Insert(v[2].point));
+		if (t.i1 != t.i2 && t.i2 != t.i3 && t.i3 != t.i1)	// skip triangles collapsed by welding
+			triangles.push_back(t);
+	}
+	return triangles.size()-nStart;
+}
 
 // ASCII OBJ
 
-#include <map>
-struct Compare {
-	bool operator() (const int3 &a, const int3 &b) const {
-		return (a.i1==b.i1? (a.i2==b.i2? a.i3 < b.i3 : a.i2 < b.i2) : a.i1 < b.i1);
+class CornerMap {
+	// map a face corner (vid, tid, nid) to its mesh vertex id; corners whose three
+	// indices agree (eg, 'f 1 2 3' or 'f 1/1/1 ...') are looked up directly by vid,
+	// others are kept in an open-addressed table with linear probing
+	// (the vid table is sized by the largest vid, so sparse users can hash every corner)
+public:
+	CornerMap(bool hashAll = false) : nEntries(0), hashAll(hashAll) { }
+	void Reserve(int nVertices, int nCorners) {
+		if (!hashAll)
+			sameIds.reserve(nVertices);
+		int capacity = 16;
+		while (capacity < 2*nCorners)
+			capacity *= 2;
+		entries.assign(capacity, Entry());
+	}
+	int Insert(const int3 &key, int id) {
+		// return id previously stored for key, else store and return id
+		if (!hashAll && key.i1 == key.i2 && key.i1 == key.i3) {
+			if (key.i1 >= (int) sameIds.size())
+				sameIds.resize(key.i1+1, -1);
+			int &sameId = sameIds[key.i1];
+			return sameId < 0? sameId = id : sameId;
+		}
+		if (2*(nEntries+1) > (int) entries.size())
+			Grow();
+		for (unsigned int mask = entries.size()-1, i = HashInt3(key)&mask;; i = (i+1)&mask) {
+			Entry &e = entries[i];
+			if (e.id < 0) {
+				e.key = key;
+				e.id = id;
+				nEntries++;
+				return id;
+			}
+			if (e.key == key)
+				return e.id;
+		}
+	}
+private:
+	struct Entry {
+		int3 key;
+		int id;							// -1 if empty
+		Entry() : id(-1) { }
+	};
+	vector<Entry> entries;				// size is a power of two, at most half full
+	vector<int> sameIds;				// indexed by vid, -1 if not yet seen
+	int nEntries;
+	bool hashAll;
+	void Grow() {
+		vector<Entry> old(2*(entries.size() > 8? entries.size() : 8));
+		old.swap(entries);
+		unsigned int mask = entries.size()-1;
+		for (int i = 0; i < (int) old.size(); i++)
+			if (old[i].id >= 0) {
+				unsigned int k = HashInt3(old[i].key)&mask;
+				while (entries[k].id >= 0)
+					k = (k+1)&mask;
+				entries[k] = old[i];
+			}
 	}
 };
 
-typedef std::map<int3, int, Compare> VidMap;
+static void CountObjRecords(const char *ptr, const char *end, int &nVertices, int &nTextures, int &nNormals, int &nFaces) {
+	// count v, vt, vn, and f lines in order to pre-size arrays
+	nVertices = nTextures = nNormals = nFaces = 0;
+	for (; ptr < end; ptr = SkipLine(ptr, end)) {
+		ptr = SkipBlanks(ptr, end);
+		char c1 = ptr < end? *ptr : 0, c2 = ptr+1 < end? ptr[1] : 0;
+		if (c1 == 'v' || c1 == 'V') {
+			if (IsBlank(c2))
+				nVertices++;
+			else if (c2 == 't' || c2 == 'T')
+				nTextures++;
+			else if (c2 == 'n' || c2 == 'N')
+				nNormals++;
+		}
+		else if ((c1 == 'f' || c1 == 'F') && IsBlank(c2))
+			nFaces++;
+	}
+}
 
-bool ReadAsciiObj(char          *filename,
-				  vector<vec3>	&points,
-				  vector<int3>	&triangles,
-				  vector<vec3>	*normals,
-				  vector<vec2>	*textures,
-				  vector<int>	*triangleGroups) {
+enum ObjRecord {O_None, O_Group, O_Vertex, O_Texture, O_Normal, O_Face};
+
+static ObjRecord ReadObjKeyword(const char *&ptr, const char *end) {
+	// read the first word of a line; blank lines, comments and unsupported attributes are O_None
+	const char *word = SkipBlanks(ptr, end);
+	ptr = SkipToken(word, end);
+	int nChars = ptr-word;
+	char c1 = nChars > 0? tolower(word[0]) : 0, c2 = nChars > 1? tolower(word[1]) : 0;
+	if (nChars == 1)
+		return c1 == 'g'? O_Group : c1 == 'v'? O_Vertex : c1 == 'f'? O_Face : O_None;
+	if (nChars == 2 && c1 == 'v')
+		return c2 == 't'? O_Texture : c2 == 'n'? O_Normal : O_None;
+	return O_None;
+}
+
+static int ReadObjCorner(const char *&ptr, const char *end, int3 &corner) {
+	// read next vid/tid/nid of a face, converted to index from 0;
+	// return 1 if read, 0 if no more corners, -1 if bad format
+	const char *s = SkipBlanks(ptr, end);
+	ptr = SkipToken(s, end);
+	// use of / is optional (ie, '3' is same as '3/3/3')
+	// an index too large for an int is a bad format, as is a negative one
+	int vid = 0, tid, nid;
+	if (s == ptr || !ReadInt(s, ptr, vid))
+		return IntDigits(s, ptr)? -1 : 0;
+	if (!vid)
+		return 0;
+	tid = nid = vid;
+	if (s < ptr && *s == '/') {
+		if (++s < ptr && *s != '/' && !ReadInt(s, ptr, tid) && IntDigits(s, ptr))
+			return -1;
+		if (s < ptr && *s == '/' && ++s < ptr && !ReadInt(s, ptr, nid) && IntDigits(s, ptr))
+			return -1;
+	}
+	// standard .obj is indexed from 1, mesh indexes from 0
+	corner = int3(vid-1, tid-1, nid-1);
+	return vid > 0 && tid > 0 && nid > 0? 1 : -1;
+}
+
+static int NFaceTriangles(int nids) { return nids == 3? 1 : nids > 3? nids-2 : 0; }
+
+static bool SetFaceTriangles(const int *vids, int nids, vector<vec3> &points, vector<vec3> *normals, int nNormals, int3 *triangles) {
+	// set NFaceTriangles(nids) triangles for a face; return true if a triangle was
+	// reversed to agree with its first vertex normal, among the first nNormals normals
+	// (those set when the face was read)
+	bool flip = false;
+	if (nids == 3) {
+		int id1 = vids[0], id2 = vids[1], id3 = vids[2];
+		if (normals && nNormals > id1) {
+			vec3 &p1 = points[id1], &p2 = points[id2], &p3 = points[id3];
+			vec3 a(p2-p1), b(p3-p2), n(cross(a, b));
+			if ((flip = dot(n, (*normals)[id1]) < 0) == true) {
+				int tmp = id1;
+				id1 = id3;
+				id3 = tmp;
+			}
+		}
+		// create triangle
+		triangles[0] = int3(id1, id2, id3);
+	}
+	else
+		// create polygon as nvids-2 triangles
+		for (int i = 1; i < nids-1; i++)
+			triangles[i-1] = int3(vids[0], vids[i], vids[(i+1)%nids]);
+	return flip;
+}
+
+// parallel OBJ: the file is split at line boundaries into chunks that are parsed
+// concurrently; each chunk dedups its own corners, the chunks' distinct corners are
+// then merged in file order, so vertex ids are the same as with a single thread; the
+// serial reader tests a corner against the vertices, textures and normals read so far,
+// so each face records those counts (in its chunk, then offset by the preceding chunks)
+
+static const int ObjChunkSize = 1 << 20, NoGroup = INT_MIN;
+
+struct ObjChunk {
+	const char *begin, *end;
+	int nLines, badLine;				// badLine is a v/vt/vn line that can't be read, else -1
+	int group;							// last group set in chunk, else NoGroup
+	vector<vec3> vertices, normals;
+	vector<vec2> textures;
+	vector<int3> corners;				// vid/tid/nid of each face corner
+	vector<int> faceSizes;				// # corners per face
+	vector<int> faceLines;
+	vector<int> faceGroups;				// NoGroup until chunk sets a group
+	vector<int3> faceCounts;			// # vertices, textures, normals before each face
+	vector<int> badFormatLines;
+	vector<int3> keys;					// distinct corners in order of first appearance
+	vector<int> ids;					// per corner, index into keys
+	vector<int3> keyCounts;				// per key, faceCounts of its first face
+	vector<int> keyIds;					// per key, mesh vertex id
+	vector<int> flipped;				// triangles reversed by SetFaceTriangles
+	int firstTriangle, nTriangles;
+	ObjChunk() : nLines(0), badLine(-1), group(NoGroup), firstTriangle(0), nTriangles(0) { }
+	void Parse() {
+		const char *ptr = begin;
+		for (int lineNum = 0; ptr < end; lineNum++, ptr = SkipLine(ptr, end), nLines++) {
+			ObjRecord r = ReadObjKeyword(ptr, end);
+			if (r == O_Group) {
+				int g;
+				if (ReadInt(ptr = SkipBlanks(ptr, end), end, g))
+					group = g;
+			}
+			else if (r == O_Vertex || r == O_Normal) {
+				vec3 v;
+				if (!ReadFloats(ptr, end, &v.x, 3)) {
+					badLine = lineNum;
+					return;
+				}
+				(r == O_Vertex? vertices : normals).push_back(v);
+			}
+			else if (r == O_Texture) {
+				vec2 t;
+				if (!ReadFloats(ptr, end, &t.x, 2)) {
+					badLine = lineNum;
+					return;
+				}
+				textures.push_back(t);
+			}
+			else if (r == O_Face) {
+				int nCorners = 0, status;
+				int3 corner;
+				while ((status = ReadObjCorner(ptr, end, corner)) > 0) {
+					corners.push_back(corner);
+					nCorners++;
+				}
+				if (status < 0)
+					badFormatLines.push_back(lineNum);
+				faceSizes.push_back(nCorners);
+				faceLines.push_back(lineNum);
+				faceGroups.push_back(group);
+				faceCounts.push_back(int3(vertices.size(), textures.size(), normals.size()));
+			}
+		}
+	}
+	void Dedup(int3 base, int firstLine) {
+		// base is # vertices, textures, normals in preceding chunks; truncate faces at any
+		// corner beyond the vertices read so far, as the serial reader does, then map
+		// corners to local keys
+		int nFaces = faceSizes.size(), nKept = 0;
+		for (int f = 0, c = 0; f < nFaces; f++) {
+			int3 &n = faceCounts[f];
+			n = int3(base.i1+n.i1, base.i2+n.i2, base.i3+n.i3);
+			int nCorners = faceSizes[f], k = 0;
+			for (; k < nCorners && corners[c+k].i1 < n.i1; k++)
+				corners[nKept+k] = corners[c+k];
+			if (k < nCorners)
+				badFormatLines.push_back(faceLines[f]);
+			c += nCorners;
+			nKept += faceSizes[f] = k;
+			nTriangles += NFaceTriangles(k);
+		}
+		corners.resize(nKept);
+		CornerMap map(true);
+		map.Reserve(base.i1+vertices.size(), nKept/2);
+		ids.resize(nKept);
+		for (int f = 0, c = 0; f < nFaces; f++)
+			for (int k = 0; k < faceSizes[f]; k++, c++)
+				if ((ids[c] = map.Insert(corners[c], keys.size())) == (int) keys.size()) {
+					keys.push_back(corners[c]);
+					keyCounts.push_back(faceCounts[f]);
+				}
+		for (int i = 0; i < (int) badFormatLines.size(); i++)
+			badFormatLines[i] += firstLine;
+	}
+};
+
+static bool ReadAsciiObjParallel(MappedFile		&in,
+								 int			nThreads,
+								 vector<vec3>	&points,
+								 vector<int3>	&triangles,
+								 vector<vec3>	*normals,
+								 vector<vec2>	*textures,
+								 vector<int>	*triangleGroups,
+								 vector<int>	*flipped,
+								 LoadMonitor	*monitor) {
+	// split into line-aligned chunks
+	const char *end = in.data+in.size;
+	int nChunks = (int) (in.size/ObjChunkSize)+1;
+	vector<ObjChunk> chunks(nChunks);
+	for (int i = 0; i < nChunks; i++) {
+		const char *b = i? chunks[i-1].end : in.data, *e = in.data+(size_t) ((double) in.size*(i+1)/nChunks);
+		chunks[i].begin = b;
+		chunks[i].end = i == nChunks-1? end : e <= b? b : SkipLine(e-1, end);
+	}
+	// parse
+	std::atomic<int> nParsed(0);
+	ParallelFor(nChunks, nThreads, [&](int i) {
+		if (monitor && monitor->cancel)
+			return;
+		chunks[i].Parse();
+		if (monitor)
+			monitor->fraction = (float) ++nParsed/nChunks;
+	});
+	if (monitor && monitor->cancel)
+		return false;
+	// report first unreadable line, concatenate vertices, textures, normals
+	vector<vec3> fileVertices, fileNormals;
+	vector<vec2> fileTextures;
+	vector<int3> bases(nChunks);			// # vertices, textures, normals in preceding chunks
+	int3 total;
+	int firstLine = 0, group = 0;
+	vector<int> firstLines(nChunks), groups(nChunks);
+	for (int i = 0; i < nChunks; i++) {
+		ObjChunk &c = chunks[i];
+		if (c.badLine >= 0) {
+			printf("bad line %d in object file", firstLine+c.badLine);
+			return false;
+		}
+		bases[i] = total;
+		total.i1 += c.vertices.size();
+		total.i2 += c.textures.size();
+		total.i3 += c.normals.size();
+		firstLines[i] = firstLine;
+		firstLine += c.nLines;
+		groups[i] = group;
+		if (c.group != NoGroup)
+			group = c.group;
+	}
+	fileVertices.resize(total.i1);
+	fileTextures.resize(total.i2);
+	fileNormals.resize(total.i3);
+	ParallelFor(nChunks, nThreads, [&](int i) {
+		ObjChunk &c = chunks[i];
+		std::copy(c.vertices.begin(), c.vertices.end(), fileVertices.begin()+bases[i].i1);
+		std::copy(c.textures.begin(), c.textures.end(), fileTextures.begin()+bases[i].i2);
+		std::copy(c.normals.begin(), c.normals.end(), fileNormals.begin()+bases[i].i3);
+		c.Dedup(bases[i], firstLines[i]);
+	});
+	// merge chunk keys in file order; assign mesh vertex ids and triangle offsets
+	CornerMap cornerMap;
+	vector<int3> keys, keyCounts;
+	vector<int> keyBases(nChunks);			// # keys in preceding chunks
+	int nTriangles = 0, idBase = points.size();
+	cornerMap.Reserve(total.i1, total.i1);
+	keys.reserve(total.i1);
+	keyCounts.reserve(total.i1);
+	for (int i = 0; i < nChunks; i++) {
+		ObjChunk &c = chunks[i];
+		for (int b = 0; b < (int) c.badFormatLines.size(); b++)
+			printf("bad format on line %d\n", c.badFormatLines[b]);
+		keyBases[i] = keys.size();
+		c.keyIds.resize(c.keys.size());
+		for (int k = 0; k < (int) c.keys.size(); k++) {
+			int id = cornerMap.Insert(c.keys[k], idBase+keys.size());
+			if (id == idBase+(int) keys.size()) {
+				keys.push_back(c.keys[k]);
+				keyCounts.push_back(c.keyCounts[k]);
+			}
+			c.keyIds[k] = id;
+		}
+		c.firstTriangle = triangles.size()+nTriangles;
+		nTriangles += c.nTriangles;
+	}
+	// a vertex has a normal (texture) if its corner's was read before the corner first appeared;
+	// normalsThrough[k] is the # of vertices through key k-1 with a normal
+	int nKeys = keys.size(), blockSize = 1 << 16, nBlocks = (nKeys+blockSize-1)/blockSize;
+	bool allNormals = normals != NULL, allTextures = textures != NULL;
+	vector<int> normalsThrough(normals? nKeys+1 : 0, 0);
+	for (int k = 0; k < nKeys && (normals || allTextures); k++) {
+		bool hasNormal = keys[k].i3 < keyCounts[k].i3;
+		allNormals = allNormals && hasNormal;
+		allTextures = allTextures && keys[k].i2 < keyCounts[k].i2;
+		if (normals)
+			normalsThrough[k+1] = normalsThrough[k]+hasNormal;
+	}
+	// set points, normals, textures
+	int normals0 = normals? normals->size() : 0;
+	points.resize(idBase+nKeys);
+	if (allNormals)
+		normals->resize(normals->size()+nKeys);
+	if (allTextures)
+		textures->resize(textures->size()+nKeys);
+	int normalBase = normals? normals->size()-(allNormals? nKeys : 0) : 0;
+	int textureBase = textures? textures->size()-(allTextures? nKeys : 0) : 0;
+	ParallelFor(nBlocks, nThreads, [&](int b) {
+		for (int k = b*blockSize, kEnd = k+blockSize < nKeys? k+blockSize : nKeys; k < kEnd; k++) {
+			points[idBase+k] = fileVertices[keys[k].i1];
+			if (allNormals)
+				(*normals)[normalBase+k] = fileNormals[keys[k].i3];
+			if (allTextures)
+				(*textures)[textureBase+k] = fileTextures[keys[k].i2];
+		}
+	});
+	for (int k = 0; k < nKeys; k++) {
+		// some corners lack a normal or texture: append only those present
+		if (normals && !allNormals && keys[k].i3 < keyCounts[k].i3)
+			normals->push_back(fileNormals[keys[k].i3]);
+		if (textures && !allTextures && keys[k].i2 < keyCounts[k].i2)
+			textures->push_back(fileTextures[keys[k].i2]);
+	}
+	// set triangles, groups
+	triangles.resize(triangles.size()+nTriangles);
+	if (triangleGroups)
+		triangleGroups->resize(triangles.size());
+	ParallelFor(nChunks, nThreads, [&](int i) {
+		ObjChunk &c = chunks[i];
+		int3 *t = triangles.data()+c.firstTriangle;
+		int *g = triangleGroups? triangleGroups->data()+c.firstTriangle : NULL;
+		for (int k = 0; k < (int) c.ids.size(); k++)
+			c.ids[k] = c.keyIds[c.ids[k]];
+		// the serial reader's normals at a face are those of the vertices through the
+		// face's largest id (vertex ids increase in order of first appearance)
+		int lastKey = keyBases[i]-1;
+		for (int f = 0, corner = 0; f < (int) c.faceSizes.size(); f++) {
+			int nids = c.faceSizes[f], n = NFaceTriangles(nids), group = c.faceGroups[f];
+			for (int k = 0; k < nids; k++)
+				lastKey = std::max(lastKey, c.ids[corner+k]-idBase);
+			int nNormals = normals? normals0+normalsThrough[lastKey+1] : 0;
+			if (SetFaceTriangles(nids? &c.ids[corner] : NULL, nids, points, normals, nNormals, t) && flipped)
+				c.flipped.push_back(t-triangles.data());
+			for (int k = 0; g && k < n; k++)
+				*g++ = group == NoGroup? groups[i] : group;
+			t += n;
+			corner += nids;
+		}
+	});
+	for (int i = 0; flipped && i < nChunks; i++)
+		flipped->insert(flipped->end(), chunks[i].flipped.begin(), chunks[i].flipped.end());
+	return true;
+}
+
+static bool ParseAsciiObj(char			*filename,
+						  vector<vec3>	&points,
+						  vector<int3>	&triangles,
+						  vector<vec3>	*normals,
+						  vector<vec2>	*textures,
+						  vector<int>	*triangleGroups,
+						  int			nThreads,
+						  vector<int>	*flipped = NULL,
+						  LoadMonitor	*monitor = NULL) {
 	// read 'object' file (Alias/Wavefront .obj format); return true if successful;
 	// polygons are assumed simple (ie, no holes and not self-intersecting);
 	// some file attributes are not supported by this implementation;
 	// obj format indexes vertices from 1
-	FILE *in = fopen(filename, "r");
-	if (!in)
+	// the file is memory-mapped and tokenized in a single pass; lines may be any length
+	MappedFile in(filename);
+	if (!in.data)
 		return false;
-	vec2 t;
-	vec3 v;
+	if (nThreads <= 0)
+		nThreads = std::thread::hardware_concurrency();
+	if (nThreads > 1 && in.size > ObjChunkSize)
+		return ReadAsciiObjParallel(in, nThreads, points, triangles, normals, textures, triangleGroups, flipped, monitor);
+	const char *ptr = in.data, *end = in.data+in.size;
 	int group = 0;
-	static const int LineLim = 1000, WordLim = 100;
-	char line[LineLim], word[WordLim];
 	vector<vec3> tmpVertices, tmpNormals;
 	vector<vec2> tmpTextures;
-	VidMap vidMap;
-	for (int lineNum = 0;; lineNum++) {
-		if (feof(in))                              // hit end of file
-			break;
-		fgets(line, LineLim, in);                  // \ line continuation not supported
-		if (strlen(line) >= LineLim-1) {           // getline reads LineLim-1 max
-			printf("line %d too long", lineNum);
-			return false;
+	vector<int> vids;
+	CornerMap cornerMap;
+	int nVertices, nTextures, nNormals, nFaces;
+	CountObjRecords(ptr, end, nVertices, nTextures, nNormals, nFaces);
+	int nUnique = nVertices > nTextures? nVertices : nTextures;
+	nUnique = nUnique > nNormals? nUnique : nNormals;
+	tmpVertices.reserve(nVertices);
+	tmpTextures.reserve(nTextures);
+	tmpNormals.reserve(nNormals);
+	cornerMap.Reserve(nVertices, nUnique);
+	points.reserve(points.size()+nUnique);
+	triangles.reserve(triangles.size()+nFaces);
+	if (normals)
+		normals->reserve(normals->size()+nUnique);
+	if (textures)
+		textures->reserve(textures->size()+nUnique);
+	if (triangleGroups)
+		triangleGroups->reserve(triangleGroups->size()+nFaces);
+	for (int lineNum = 0; ptr < end; lineNum++, ptr = SkipLine(ptr, end)) {
+		if (monitor && !(lineNum&0xFFF)) {
+			monitor->fraction = (float) (ptr-in.data)/in.size;
+			if (monitor->cancel)
+				return false;
 		}
-		char *ptr = line;
-		if (!ReadWord(ptr, word, WordLim))
-			continue;
-		else if (*word == '#')
-			continue;
-		else if (!_stricmp(word, "g"))
+		// \ line continuation not supported
+		ObjRecord r = ReadObjKeyword(ptr, end);
+		if (r == O_Group)
 			// this implementation: group field significant only if integer
 			// .obj format, however, supported arbitrary string identifier
-			sscanf(ptr, "%d", &group);
-		else if (!_stricmp(word, "v")) {           // read vertex coordinates
-			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
+			ReadInt(ptr = SkipBlanks(ptr, end), end, group);
+		else if (r == O_Vertex) {					// read vertex coordinates
+			vec3 v;
+			if (!ReadFloats(ptr, end, &v.x, 3)) {
 				printf("bad line %d in object file", lineNum);
 				return false;
 			}
-			tmpVertices.push_back(vec3(v.x, v.y, v.z));
+			tmpVertices.push_back(v);
 		}
-		else if (!_stricmp(word, "vn")) {          // read vertex normal
-			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
+		else if (r == O_Normal) {					// read vertex normal
+			vec3 n;
+			if (!ReadFloats(ptr, end, &n.x, 3)) {
 				printf("bad line %d in object file", lineNum);
 				return false;
 			}
-			tmpNormals.push_back(vec3(v.x, v.y, v.z));
+			tmpNormals.push_back(n);
 		}
-		else if (!_stricmp(word, "vt")) {          // read vertex texture
-			if (sscanf(ptr, "%g%g", &t.x, &t.y) != 2) {
-				printf("bad line in object file");
+		else if (r == O_Texture) {					// read vertex texture
+			vec2 t;
+			if (!ReadFloats(ptr, end, &t.x, 2)) {
+				printf("bad line %d in object file", lineNum);
 				return false;
 			}
-			tmpTextures.push_back(vec2(t.x, t.y));
+			tmpTextures.push_back(t);
 		}
-		else if (!_stricmp(word, "f")) {           // read triangle or polygon
-		//	printf("line = %s\n", line);
-			static vector<int> vids;
+		else if (r == O_Face) {						// read triangle or polygon
 			vids.resize(0);
-			while (ReadWord(ptr, word, WordLim)) { // read arbitrary # face vid/tid/nid        
-			//	printf("word = %s\n", word);
-				// set texture and normal pointers to preceding /
-				char *tPtr = strchr(word+1, '/');  // pointer to /, or null if not found
-				char *nPtr = tPtr? strchr(tPtr+1, '/') : NULL;
-				// use of / is optional (ie, '3' is same as '3/3/3')
-				// convert to vid, tid, nid indices (vertex, texture, normal)
-				int vid = atoi(word);
-				if (!vid) // atoi returns 0 if failure to convert
-					break;
-				int tid = tPtr && *++tPtr != '/'? atoi(tPtr) : vid;
-				int nid = nPtr && *++nPtr != 0? atoi(nPtr) : vid;
-				// standard .obj is indexed from 1, mesh indexes from 0
-				vid--;
-				tid--;
-				nid--;
-				if (vid < 0 || tid < 0 || nid < 0) { // atoi = 0 is conversion failure
+			int3 corner;
+			for (int status; (status = ReadObjCorner(ptr, end, corner)) != 0; ) {
+				// read arbitrary # face vid/tid/nid
+				int vid = corner.i1, tid = corner.i2, nid = corner.i3;
+				if (status < 0 || vid >= (int) tmpVertices.size()) {
 					printf("bad format on line %d\n", lineNum);
 					break;
 				}
-				int3 key(vid, tid, nid);
-				VidMap::iterator it = vidMap.find(key);
-				if (it == vidMap.end()) {
-					int nvrts = points.size();
-					vidMap[key] = nvrts;
+				int nvrts = points.size(), id = cornerMap.Insert(corner, nvrts);
+				if (id == nvrts) {
 					points.push_back(tmpVertices[vid]);
 					if (normals && (int) tmpNormals.size() > nid)
 						normals->push_back(tmpNormals[nid]);
 					if (textures && (int) tmpTextures.size() > tid)
 						textures->push_back(tmpTextures[tid]);
-					vids.push_back(nvrts);
 				}
-				else
-					vids.push_back(it->second);
-			}
-			int nids = vids.size();
-			if (nids == 3) {
-				int id1 = vids[0], id2 = vids[1], id3 = vids[2];
-				if (normals && (int) normals->size() > id1) {
-					vec3 &p1 = points[id1], &p2 = points[id2], &p3 = points[id3];
-					vec3 a(p2-p1), b(p3-p2), n(cross(a, b));
-					if (dot(n, (*normals)[id1]) < 0) {
-						int tmp = id1;
-						id1 = id3;
-						id3 = id1;
-					}
-				}
-				// create triangle
-				triangles.push_back(int3(id1, id2, id3));
-				if (triangleGroups)
-					triangleGroups->push_back(group);
+				vids.push_back(id);
 			}
-			else
-				// create polygon as nvids-2 triangles
-				for (int i = 1; i < nids-1; i++) {
-					triangles.push_back(int3(vids[0], vids[i], vids[(i+1)%nids]));
-					if (triangleGroups)
-						triangleGroups->push_back(group);
-				}
-		}
-		else if (*word == 0 || *word== '\n')                     // skip blank line
-			continue;
-		else {                                     // unrecognized attribute
-			// printf("unsupported attribute in object file: %s", word);
-			continue; // return false;
+			int nids = vids.size(), n = NFaceTriangles(nids);
+			triangles.resize(triangles.size()+n);
+			if (SetFaceTriangles(nids? &vids[0] : NULL, nids, points, normals, normals? normals->size() : 0, n? &triangles[triangles.size()-n] : NULL) && flipped)
+				flipped->push_back(triangles.size()-n);
+			if (triangleGroups)
+				triangleGroups->resize(triangleGroups->size()+n, group);
 		}
 	} // end read til end of file
 	//if (vertexNormals)
 	//	SetVertexNormals(vertices, triangles, *vertexNormals);
 	return true;
-} // end ReadAsciiObj
+} // end ParseAsciiObj
+
+static bool LoadAsciiObj(char			*filename,
+						 vector<vec3>	&points,
+						 vector<int3>	&triangles,
+						 vector<vec3>	*normals,
+						 vector<vec2>	*textures,
+						 vector<int>	*triangleGroups,
+						 int			nThreads,
+						 LoadMonitor	*monitor) {
+	// read from filename.meshbin if current, else parse all arrays and save them there
+	MeshCache cache;
+	if (!cache.Read(filename, MeshCache::C_Obj)) {
+		if (!useMeshCache)
+			return ParseAsciiObj(filename, points, triangles, normals, textures, triangleGroups, nThreads, NULL, monitor);
+		if (!ParseAsciiObj(filename, cache.points, cache.triangles, &cache.normals, &cache.textures, &cache.groups, nThreads, &cache.flipped, monitor))
+			return false;
+		cache.Write(filename, MeshCache::C_Obj);
+	}
+	// a triangle is reversed to agree with its normal only if normals are requested
+	if (!normals)
+		for (int i = 0; i < (int) cache.flipped.size(); i++) {
+			int3 &t = cache.triangles[cache.flipped[i]];
+			std::swap(t.i1, t.i3);
+		}
+	if (int idBase = points.size())
+		for (int i = 0; i < (int) cache.triangles.size(); i++) {
+			int3 &t = cache.triangles[i];
+			t = int3(t.i1+idBase, t.i2+idBase, t.i3+idBase);
+		}
+	Append(points, cache.points);
+	Append(triangles, cache.triangles);
+	if (normals)
+		Append(*normals, cache.normals);
+	if (textures)
+		Append(*textures, cache.textures);
+	if (triangleGroups)
+		Append(*triangleGroups, cache.groups);
+	return true;
+} // end LoadAsciiObj
+
+bool ReadAsciiObj(char          *filename,
+				  vector<vec3>	&points,
+				  vector<int3>	&triangles,
+				  vector<vec3>	*normals,
+				  vector<vec2>	*textures,
+				  vector<int>	*triangleGroups,
+				  int			nThreads) {
+	return LoadAsciiObj(filename, points, triangles, normals, textures, triangleGroups, nThreads, NULL);
+}
+
+// asynchronous loading
+
+void MeshLoader::Start(char *filename, bool readNormals, bool readTextures, int nThreads) {
+	Cancel();
+	points.resize(0);
+	normals.resize(0);
+	triangles.resize(0);
+	textures.resize(0);
+	monitor.fraction = 0;
+	monitor.cancel = false;
+	state = Loading;
+	string name(filename);
+	worker = std::thread([this, name, readNormals, readTextures, nThreads]() {
+		bool ok = LoadAsciiObj((char *) name.c_str(), points, triangles, readNormals? &normals : NULL,
+							   readTextures? &textures : NULL, NULL, nThreads, &monitor);
+		if (ok)
+			monitor.fraction = 1;
+		state = ok? Loaded : monitor.cancel? Cancelled : Failed;
+	});
+}
+
+MeshLoader::State MeshLoader::Poll() {
+	State s = (State) state.load();
+	if (s != Loading && worker.joinable())
+		worker.join();
+	return s;
+}
+
+void MeshLoader::Cancel() {
+	monitor.cancel = true;
+	if (worker.joinable())
+		worker.join();
+	if (state != Loaded) {
+		// release a partial mesh
+		vector<vec3>().swap(points);
+		vector<vec3>().swap(normals);
+		vector<int3>().swap(triangles);
+		vector<vec2>().swap(textures);
+	}
+	if (state == Loading)
+		state = Cancelled;
+}
+
+// streaming
+
+int StreamSTL(char *filename, TriangleBatch batch, void *data, int batchSize) {
+	MappedFile in(filename);
+	if (!in.data) {
+		printf("can't open %s\n", filename);
+		return -1;
+	}
+	if (batchSize < 1)
+		batchSize = 1;
+	vector<VertexSTL> vertices;
+	int nTriangles = 0;
+	if (IsBinarySTL(in.data, in.size)) {
+		int nRecords = BinarySTLCount(in.data, in.size);
+		if (nRecords < 0)
+			return -1;
+		vertices.resize(3*(size_t) (nRecords < batchSize? nRecords : batchSize));
+		for (int n; nTriangles < nRecords; ) {
+			n = nRecords-nTriangles < batchSize? nRecords-nTriangles : batchSize;
+			DecodeBinarySTL(in.data+STLHeaderSize+(size_t) nTriangles*STLRecordSize, n, &vertices[0]);
+			nTriangles += n;
+			if (!batch(&vertices[0], n, data))
+				break;
+			in.Release(in.data+STLHeaderSize+(size_t) nTriangles*STLRecordSize);
+		}
+	}
+	else {
+		const char *ptr = in.data, *end = in.data+in.size;
+		vertices.reserve(3*(size_t) batchSize);
+		for (int n; ; ) {
+			vertices.resize(0);
+			if ((n = ParseAsciiSTL(ptr, in.data, end, vertices, batchSize)) < 0)
+				return -1;
+			nTriangles += n;
+			if (!n || !batch(&vertices[0], n, data))
+				break;
+			in.Release(ptr);
+		}
+	}
+	return nTriangles;
+}
+
+static void AddObjTriangle(vector<VertexSTL> &vertices, vector<vec3> &points, vector<vec3> &normals, int3 c1, int3 c2, int3 c3, bool orient) {
+	// append the corners as a triangle; a corner without a normal gets the triangle's normal;
+	// if orient, reverse the triangle when it disagrees with the first corner's normal (as ReadAsciiObj)
+	vec3 n = cross(points[c2.i1]-points[c1.i1], points[c3.i1]-points[c2.i1]);
+	if (orient && c1.i3 < (int) normals.size() && dot(n, normals[c1.i3]) < 0) {
+		int3 c = c1;
+		c1 = c3;
+		c3 = c;
+		n = -n;
+	}
+	float len = length(n);
+	if (len > 0)
+		n /= len;
+	int3 corners[] = {c1, c2, c3};
+	for (int k = 0; k < 3; k++) {
+		int3 &c = corners[k];
+		vertices.push_back(VertexSTL(&points[c.i1].x, c.i3 < (int) normals.size()? &normals[c.i3].x : &n.x));
+	}
+}
+
+int StreamAsciiObj(char *filename, TriangleBatch batch, void *data, int batchSize) {
+	// faces are converted as they are read, so only the v and vn records are kept
+	MappedFile in(filename);
+	if (!in.data) {
+		printf("can't open %s\n", filename);
+		return -1;
+	}
+	if (batchSize < 1)
+		batchSize = 1;
+	const char *ptr = in.data, *end = in.data+in.size;
+	vector<vec3> points, normals;
+	vector<VertexSTL> vertices;
+	vector<int3> corners;
+	int nTriangles = 0;
+	vertices.reserve(3*(size_t) batchSize);
+	for (int lineNum = 0; ptr < end; lineNum++, ptr = SkipLine(ptr, end)) {
+		in.Release(ptr);
+		ObjRecord r = ReadObjKeyword(ptr, end);
+		if (r == O_Vertex || r == O_Normal) {
+			vec3 v;
+			if (!ReadFloats(ptr, end, &v.x, 3)) {
+				printf("bad line %d in object file", lineNum);
+				return -1;
+			}
+			(r == O_Vertex? points : normals).push_back(v);
+		}
+		else if (r == O_Face) {
+			corners.resize(0);
+			int3 corner;
+			for (int status; (status = ReadObjCorner(ptr, end, corner)) != 0; ) {
+				if (status < 0 || corner.i1 >= (int) points.size()) {
+					printf("bad format on line %d\n", lineNum);
+					break;
+				}
+				corners.push_back(corner);
+			}
+			int nCorners = corners.size();
+			for (int i = 1; i < nCorners-1; i++)
+				AddObjTriangle(vertices, points, normals, corners[0], corners[i], corners[i+1], nCorners == 3);
+			int n = vertices.size()/3;
+			if (n >= batchSize) {
+				nTriangles += n;
+				if (!batch(&vertices[0], n, data))
+					return nTriangles;
+				vertices.resize(0);
+			}
+		}
+	}
+	int n = vertices.size()/3;
+	if (n) {
+		nTriangles += n;
+		batch(&vertices[0], n, data);
+	}
+	return nTriangles;
+}
 
 // texture
 
+static void ExpandPixels(unsigned char *row, int width, int inBytes, int outBytes, const unsigned char *palette, int nColors) {
+	// in place, convert width pixels of inBytes (16-bit or palette index) to outBytes (BGR or BGRA);
+	// backwards, since output pixels are at least as large as input pixels
+	for (int i = width-1; i >= 0; i--) {
+		const unsigned char *s = row+i*inBytes;
+		unsigned char *d = row+i*outBytes;
+		if (palette) {
+			int index = inBytes == 1? s[0] : s[0] | s[1] << 8;
+			const unsigned char *c = palette+(index < nColors? index : 0)*outBytes;
+			for (int k = outBytes-1; k >= 0; k--)
+				d[k] = c[k];
+		}
+		else {
+			// A1R5G5B5, little-endian; each 5-bit channel replicated into 8 bits
+			int p = s[0] | s[1] << 8, r = (p >> 10)&31, g = (p >> 5)&31, b = p&31;
+			d[2] = (unsigned char) (r << 3 | r >> 2);
+			d[1] = (unsigned char) (g << 3 | g >> 2);
+			d[0] = (unsigned char) (b << 3 | b >> 2);
+		}
+	}
+}
+
+struct Targa {
+	// a memory-mapped .tga, as read by ParseTarga
+	const unsigned char *src, *end, *palette;	// first pixel, end of file, color map (or NULL)
+	int width, height, inBytes, outBytes, mapFirst, mapLength;
+	bool rle, rightToLeft, topToBottom;
+};
+
+static bool ParseTarga(const char *filename, const MappedFile &in, Targa &t, bool report = true) {
+	// read the header; return false (with a message, if report) if unreadable or unsupported
+	// # bytes   field
+	// -------   -----
+	//       1   image ID length (ID follows header)
+	//       1   color map type (1 if present)
+	//       1   image type: 1 color-mapped, 2 true-color, 3 grayscale, +8 if RLE
+	//       5   color map: first index (2), # entries (2), bits per entry (1)
+	//       4   x, y origin (ignored)
+	//       4   width, height
+	//       1   bits per pixel: 8, 15, 16, 24, or 32
+	//       1   descriptor: bits 0-3 alpha bits, bit 4 right-to-left, bit 5 top-to-bottom
+	const unsigned char *data = (const unsigned char *) in.data;
+	if (!data || in.size < 18) {
+		if (report)
+			printf("can't open %s\n", filename);
+		return false;
+	}
+	t.end = data+in.size;
+	t.src = data+18;
+	int idLength = data[0], mapType = data[1], imageType = data[2]&7;
+	int mapBits = data[7], pixelBits = data[16], descriptor = data[17];
+	t.mapFirst = data[3] | data[4] << 8;
+	t.mapLength = data[5] | data[6] << 8;
+	t.rle = (data[2]&8) != 0;
+	t.rightToLeft = (descriptor&16) != 0;
+	t.topToBottom = (descriptor&32) != 0;
+	t.width = data[12] | data[13] << 8;
+	t.height = data[14] | data[15] << 8;
+	int mapBytes = (mapBits+7)/8;
+	t.inBytes = t.outBytes = (pixelBits+7)/8;
+	bool formatOk = imageType == 1? mapType == 1 && (pixelBits == 8 || pixelBits == 16) && (mapBits == 24 || mapBits == 32) :
+					imageType == 2? pixelBits == 15 || pixelBits == 16 || pixelBits == 24 || pixelBits == 32 :
+					imageType == 3? pixelBits == 8 : false;
+	if (!formatOk || !t.width || !t.height) {
+		if (report)
+			printf("%s: unsupported targa (type %i, %i bits per pixel)\n", filename, data[2], pixelBits);
+		return false;
+	}
+	// skip image ID and color map; a color map (BGR or BGRA entries) is used only by a color-mapped image
+	size_t skip = idLength+(mapType == 1? (size_t) t.mapLength*mapBytes : 0);
+	if ((size_t) (t.end-t.src) < skip) {
+		if (report)
+			printf("%s: truncated targa\n", filename);
+		return false;
+	}
+	t.palette = imageType == 1? t.src+idLength : NULL;
+	t.src += skip;
+	if (imageType == 1)
+		t.outBytes = mapBytes;
+	if (imageType == 2 && t.inBytes == 2)
+		t.outBytes = 3;
+	return true;
+}
+
+static vector<unsigned char> TargaMap(const Targa &t) {
+	// color map entries in index order, starting at mapFirst; empty if not color-mapped
+	vector<unsigned char> map;
+	if (t.palette) {
+		map.assign((size_t) (t.mapFirst+t.mapLength)*t.outBytes, 0);
+		memcpy(&map[(size_t) t.mapFirst*t.outBytes], t.palette, (size_t) t.mapLength*t.outBytes);
+	}
+	return map;
+}
+
+template <class Allocate>
+static bool DecodeTarga(const char *filename, int &width, int &height, int &bitsPerPixel, Allocate allocate) {
+	// decode into allocate(# bytes), called once width, height and bitsPerPixel are set;
+	// return false if unreadable, or if allocate returns NULL
+	// every read is checked against the end of the (memory-mapped) file
+	MappedFile in(filename);
+	Targa t;
+	if (!ParseTarga(filename, in, t))
+		return false;
+	const unsigned char *src = t.src, *end = t.end, *palette = t.palette;
+	int inBytes = t.inBytes, outBytes = t.outBytes;
+	bool rle = t.rle, rightToLeft = t.rightToLeft, topToBottom = t.topToBottom;
+	width = t.width;
+	height = t.height;
+	bitsPerPixel = 8*outBytes;
+	// rows are produced bottom to top (as glTexImage2D expects) directly in the output
+	int rowBytes = width*outBytes, inRowBytes = width*inBytes;
+	char *pixels = allocate((size_t) height*rowBytes);
+	if (!pixels)
+		return false;
+	vector<unsigned char> map = TargaMap(t);
+	int packetLeft = 0;
+	bool packetRun = false, ok = true;
+	unsigned char runPixel[4];
+	for (int r = 0; r < height && ok; r++) {
+		unsigned char *row = (unsigned char *) pixels+(size_t) (topToBottom? height-1-r : r)*rowBytes, *d = row;
+		if (!rle) {
+			if ((ok = end-src >= inRowBytes)) {
+				memcpy(d, src, inRowBytes);
+				src += inRowBytes;
+			}
+		}
+		else
+			// a packet is a header byte (count-1, high bit set for a run) followed by one
+			// pixel for a run or count pixels; packets may cross rows
+			for (int n = width; n > 0; ) {
+				if (!packetLeft) {
+					int headerBytes = src < end && *src&128? 1+inBytes : 1;
+					if (!(ok = end-src >= headerBytes))
+						break;
+					packetLeft = (*src&127)+1;
+					packetRun = headerBytes > 1;
+					memcpy(runPixel, src+1, headerBytes-1);
+					src += headerBytes;
+				}
+				int k = n < packetLeft? n : packetLeft, nBytes = k*inBytes;
+				if (packetRun) {
+					if (inBytes == 1)
+						memset(d, runPixel[0], k);
+					else
+						for (int i = 0; i < nBytes; i += inBytes)
+							memcpy(d+i, runPixel, inBytes);
+				}
+				else {
+					if (!(ok = end-src >= nBytes))
+						break;
+					memcpy(d, src, nBytes);
+					src += nBytes;
+				}
+				d += nBytes;
+				n -= k;
+				packetLeft -= k;
+			}
+		if (ok && (inBytes != outBytes || palette))
+			ExpandPixels(row, width, inBytes, outBytes, palette? &map[0] : NULL, t.mapFirst+t.mapLength);
+		if (ok && rightToLeft)
+			for (unsigned char *p1 = row, *p2 = row+rowBytes-outBytes; p1 < p2; p1 += outBytes, p2 -= outBytes)
+				for (int k = 0; k < outBytes; k++)
+					std::swap(p1[k], p2[k]);
+	}
+	if (!ok)
+		printf("%s: truncated targa\n", filename);
+	return ok;
+}
+
 char *ReadTexture(const char *filename, int &width, int &height, int &bitsPerPixel) {
-	// open targa file, read header
-	FILE *in = fopen(filename, "rb");
 	char *pixels = NULL;
-	if (in) {
-		short tgaHeader[9];
-		fread(tgaHeader, sizeof(tgaHeader), 1, in);
-		// allocate, read pixels
-		width = tgaHeader[6];
-		height = tgaHeader[7];
-		bitsPerPixel = tgaHeader[8];
-		int bytesPerPixel = bitsPerPixel/8;
-		int bytesPerImage = width*height*bytesPerPixel;
-		if (bytesPerPixel == 3) {
-			pixels = new char[bytesPerImage];
-			fread(pixels, bytesPerImage, 1, in);
+	if (!DecodeTarga(filename, width, height, bitsPerPixel, [&pixels](size_t nBytes) { return pixels = new char[nBytes]; })) {
+		delete [] pixels;
+		return NULL;
+	}
+	return pixels;
+}
+
+static char *SampleTarga(const char *filename, int size, int &width, int &height, int &bitsPerPixel) {
+	// nearest samples of an uncompressed targa, halved (as for a mip level) until no larger than
+	// size on a side, read without decoding the rest; return NULL if unreadable, truncated, RLE, or
+	// already no larger than size
+	MappedFile in(filename);
+	Targa t;
+	if (!ParseTarga(filename, in, t, false) || t.rle || (size_t) (t.end-t.src) < (size_t) t.width*t.height*t.inBytes ||
+		(t.width <= size && t.height <= size))
+		return NULL;
+	for (width = t.width, height = t.height; width > size || height > size; ) {
+		width = width > 1? width/2 : 1;
+		height = height > 1? height/2 : 1;
+	}
+	bitsPerPixel = 8*t.outBytes;
+	vector<unsigned char> map = TargaMap(t);
+	char *pixels = new char[(size_t) width*height*t.outBytes];
+	for (int j = 0; j < height; j++) {
+		// rows bottom to top, sampled at the center of each output texel
+		int y = (int) ((2LL*j+1)*t.height/(2*height)), r = t.topToBottom? t.height-1-y : y;
+		unsigned char *row = (unsigned char *) pixels+(size_t) j*width*t.outBytes;
+		for (int i = 0; i < width; i++) {
+			int x = (int) ((2LL*i+1)*t.width/(2*width)), c = t.rightToLeft? t.width-1-x : x;
+			memcpy(row+i*t.inBytes, t.src+((size_t) r*t.width+c)*t.inBytes, t.inBytes);
 		}
+		if (t.inBytes != t.outBytes || t.palette)
+			ExpandPixels(row, width, t.inBytes, t.outBytes, t.palette? &map[0] : NULL, t.mapFirst+t.mapLength);
+	}
+	return pixels;
+}
+
+GLenum TextureFormat(int bitsPerPixel) {
+	return bitsPerPixel == 8? GL_RED : bitsPerPixel == 32? GL_BGRA : GL_BGR;
+}
+
+// pixel conversion
+
+// luminance is .21 red + .72 green + .07 blue in 15-bit fixed point, rounded; SSE handles four
+// pixels at a time, each in a 32-bit lane (a 24-bit pixel is loaded with the next pixel's first
+// byte, which gets weight 0)
+
+static const int LumR = 6881, LumG = 23593, LumB = 2294;		// sum 32768
+
+static inline unsigned char LuminanceOf(const unsigned char *bgr) {
+	return (unsigned char) ((LumR*bgr[2]+LumG*bgr[1]+LumB*bgr[0]+16384) >> 15);
+}
+
+void BGRToLuminance(const unsigned char *pixels, int nPixels, int bytesPerPixel, unsigned char *luminance) {
+	int i = 0;
+#ifdef USE_SSE
+	// stop four pixels early for 24-bit, so the last load stays within pixels
+	int nSSE = bytesPerPixel == 4? nPixels-3 : nPixels-4;
+	__m128i zero = _mm_setzero_si128(), round = _mm_set1_epi32(16384);
+	__m128i weights = _mm_setr_epi16(LumB, LumG, LumR, 0, LumB, LumG, LumR, 0);
+	for (; i < nSSE; i += 4) {
+		const unsigned char *p = pixels+i*bytesPerPixel;
+		int b = bytesPerPixel, p0, p1, p2, p3;
+		memcpy(&p0, p, 4);
+		memcpy(&p1, p+b, 4);
+		memcpy(&p2, p+2*b, 4);
+		memcpy(&p3, p+3*b, 4);
+		__m128i v = _mm_setr_epi32(p0, p1, p2, p3);
+		__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights);	// b+g, r for pixels 0, 1
+		__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights);	// pixels 2, 3
+		__m128 flo = _mm_castsi128_ps(lo), fhi = _mm_castsi128_ps(hi);
+		__m128i even = _mm_castps_si128(_mm_shuffle_ps(flo, fhi, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i odd = _mm_castps_si128(_mm_shuffle_ps(flo, fhi, _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128i l = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), round), 15);
+		l = _mm_packs_epi32(l, l);
+		int out = _mm_cvtsi128_si32(_mm_packus_epi16(l, l));
+		memcpy(luminance+i, &out, 4);
+	}
+#endif
+	for (; i < nPixels; i++)
+		luminance[i] = LuminanceOf(pixels+i*bytesPerPixel);
+}
+
+void SwapRedBlue(unsigned char *pixels, int nPixels, int bytesPerPixel) {
+	int i = 0;
+#ifdef USE_SSE
+	if (bytesPerPixel == 4) {
+		__m128i keep = _mm_set1_epi32(0xFF00FF00), low = _mm_set1_epi32(0xFF);
+		for (; i+4 <= nPixels; i += 4) {
+			__m128i v = _mm_loadu_si128((__m128i *) (pixels+4*i));
+			__m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low), b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+			_mm_storeu_si128((__m128i *) (pixels+4*i), _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(r, b)));
+		}
+	}
+#endif
+	for (unsigned char *p = pixels+i*bytesPerPixel; i < nPixels; i++, p += bytesPerPixel)
+		std::swap(p[0], p[2]);
+}
+
+void WidenTo16(const unsigned char *in, int n, unsigned short *out) {
+	// v*257, so 255 becomes 65535
+	int i = 0;
+#ifdef USE_SSE
+	for (; i+16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((__m128i *) (in+i));
+		_mm_storeu_si128((__m128i *) (out+i), _mm_unpacklo_epi8(v, v));
+		_mm_storeu_si128((__m128i *) (out+i+8), _mm_unpackhi_epi8(v, v));
+	}
+#endif
+	for (; i < n; i++)
+		out[i] = (unsigned short) (in[i]*257);
+}
+
+// height maps
+
+static bool HasExtension(const char *filename, const char *ext) {
+	size_t n = strlen(filename), e = strlen(ext);
+	return n > e && _stricmp(filename+n-e, ext) == 0;
+}
+
+static bool PnmInt(const char *&p, const char *end, int &i) {
+	// header integer of a .pgm or .pfm, after white space and # comments
+	while (p < end && (IsSpace(*p) || *p == '#'))
+		p = *p == '#'? SkipLine(p, end) : p+1;
+	return ReadInt(p, end, i) && i > 0;
+}
+
+bool HeightMap::Read(const char *filename) {
+	MappedFile in(filename);
+	const char *p = in.data, *end = in.data+in.size;
+	bool pgm = HasExtension(filename, ".pgm"), pfm = HasExtension(filename, ".pfm");
+	width = height = 0;
+	heights.resize(0);
+	ranges.resize(0);
+	if (!in.data) {
+		printf("can't open %s\n", filename);
+		return false;
+	}
+	if (!pgm && !pfm && !HasExtension(filename, ".r32")) {
+		// .tga, as luminance
+		int bitsPerPixel;
+		char *pixels = ReadTexture(filename, width, height, bitsPerPixel);
+		if (!pixels)
+			return false;
+		vector<unsigned char> l((size_t) width*height);
+		if (bitsPerPixel == 8)
+			memcpy(&l[0], pixels, l.size());
 		else
-			printf("bytes per pixel = %i!\n", bytesPerPixel);
-		fclose(in);
+			BGRToLuminance((unsigned char *) pixels, width*height, bitsPerPixel/8, &l[0]);
+		delete [] pixels;
+		bits = 8;
+		heights.resize(l.size());
+		for (size_t i = 0; i < l.size(); i++)
+			heights[i] = l[i]/255.f;
+		return true;
+	}
+	float scale = -1;								// .pfm: negative if little-endian
+	int maxValue = 0;
+	if (pgm || pfm) {
+		// header: P5 (.pgm) or Pf (.pfm), width, height, maximum value (.pgm) or scale (.pfm),
+		// then a single white space character
+		bool ok = in.size > 2 && p[0] == 'P' && p[1] == (pgm? '5' : 'f');
+		p += 2;
+		ok = ok && PnmInt(p, end, width) && PnmInt(p, end, height) && width <= 65535 && height <= 65535;
+		if (ok && pgm)
+			ok = PnmInt(p, end, maxValue) && maxValue <= 65535;
+		if (ok && pfm) {
+			while (p < end && IsSpace(*p))
+				p++;
+			ok = ReadFloat(p, end, scale) && scale != 0;
+		}
+		if (!ok || p >= end || !IsSpace(*p++)) {
+			printf("%s: unsupported or malformed header\n", filename);
+			return false;
+		}
+	}
+	else {
+		// .r32: square, no header
+		width = height = (int) sqrt((double) (in.size/4));
+		while ((size_t) (width+1)*(width+1)*4 <= in.size)
+			width = ++height;
 	}
+	bits = pgm? (maxValue < 256? 8 : 16) : 32;
+	size_t n = (size_t) width*height, bytes = bits/8;
+	if (!n || (size_t) (end-p) < n*bytes || (!pgm && !pfm && in.size != n*4)) {
+		printf("%s: truncated or not square\n", filename);
+		return false;
+	}
+	heights.resize(n);
+	const unsigned char *d = (const unsigned char *) p;
+	bool swap = pfm && scale > 0;					// big-endian .pfm
+	for (int row = 0; row < height; row++) {
+		// .pgm rows are top to bottom, .pfm and .r32 bottom to top
+		float *h = &heights[(size_t) (pgm? height-1-row : row)*width];
+		for (int i = 0; i < width; i++, d += bytes)
+			if (bits == 8)
+				h[i] = d[0]/(float) maxValue;
+			else if (bits == 16)
+				h[i] = (d[0] << 8 | d[1])/(float) maxValue;		// big-endian
+			else {
+				unsigned char b[4] = {d[0], d[1], d[2], d[3]};
+				if (swap) {
+					std::swap(b[0], b[3]);
+					std::swap(b[1], b[2]);
+				}
+				memcpy(&h[i], b, 4);
+			}
+	}
+	return true;
+}
+
+static char *HeightPixels(const vector<float> &heights, int bits, char *pixels = NULL) {
+	// texels for GL_R32F (bits 32) or GL_R16, written to pixels if given, else to a new array
+	// the caller deletes []
+	if (!pixels)
+		pixels = new char[heights.size()*(bits == 32? 4 : 2)];
+	if (bits == 32)
+		memcpy(pixels, &heights[0], heights.size()*4);
+	else
+		for (size_t i = 0; i < heights.size(); i++) {
+			unsigned short h = (unsigned short) (heights[i]*65535+.5f);
+			memcpy(pixels+2*i, &h, 2);
+		}
 	return pixels;
 }
 
-GLuint SetHeightfield(const char *filename, int whichTexture) {
+static void HalveHeights(vector<float> &heights, int &width, int &height) {
+	// as HalveImage
+	int w = width > 1? width/2 : 1, h = height > 1? height/2 : 1;
+	vector<float> half((size_t) w*h);
+	for (int j = 0; j < h; j++)
+		for (int i = 0; i < w; i++) {
+			int x0 = 2*i < width? 2*i : width-1, x1 = 2*i+1 < width? 2*i+1 : x0;
+			int y0 = 2*j < height? 2*j : height-1, y1 = 2*j+1 < height? 2*j+1 : y0;
+			half[(size_t) j*w+i] = .25f*(heights[(size_t) y0*width+x0]+heights[(size_t) y0*width+x1]+
+										 heights[(size_t) y1*width+x0]+heights[(size_t) y1*width+x1]);
+		}
+	heights.swap(half);
+	width = w;
+	height = h;
+}
+
+static void UploadHeights(const HeightMap &map) {
+	// to the bound texture: R16 for integer heights, R32F for float
+	char *pixels = HeightPixels(map.heights, map.bits);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, map.bits == 32? GL_R32F : GL_R16, map.width, map.height, 0, GL_RED,
+				 map.bits == 32? GL_FLOAT : GL_UNSIGNED_SHORT, pixels);
+	delete [] pixels;
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+GLuint HeightMap::Upload() {
 	GLuint textureId = 0;
+	if (heights.empty())
+		return 0;
 	glGenTextures(1, &textureId);
-	// open targa file, read header, store as GL_TEXTURE2
+	glBindTexture(GL_TEXTURE_2D, textureId);
+	UploadHeights(*this);
+	return textureId;
+}
+
+void HeightMap::BuildRanges() {
+	ranges.resize(0);
+	for (int level = 1, w = width, h = height; w > 1 || h > 1; level++) {
+		int w2 = (w+1)/2, h2 = (h+1)/2;
+		ranges.push_back(vector<vec2>((size_t) w2*h2));
+		vector<vec2> &r = ranges.back();
+		for (int j = 0; j < h2; j++)
+			for (int i = 0; i < w2; i++) {
+				vec2 &m = r[(size_t) j*w2+i];
+				m = vec2(FLT_MAX, -FLT_MAX);
+				for (int y = 2*j; y < 2*j+2 && y < h; y++)
+					for (int x = 2*i; x < 2*i+2 && x < w; x++) {
+						vec2 below = RangeAt(level-1, x, y);
+						m.x = std::min(m.x, below.x);
+						m.y = std::max(m.y, below.y);
+					}
+			}
+		w = w2;
+		h = h2;
+	}
+}
+
+vec2 HeightMap::RangeAt(int level, int x, int y) {
+	if (!level) {
+		float v = heights[(size_t) y*width+x];
+		return vec2(v, v);
+	}
+	int w = width;
+	for (int k = 0; k < level; k++)
+		w = (w+1)/2;
+	return ranges[level-1][(size_t) y*w+x];
+}
+
+vec2 HeightMap::Range(float u0, float v0, float u1, float v1) {
+	// find the level at which the rectangle spans at most 2x2 entries
+	if (heights.empty())
+		return vec2(0, 0);
+	if (ranges.empty() && (width > 1 || height > 1))
+		BuildRanges();
+	int x0 = std::max(0, std::min(width-1, (int) floor(std::min(u0, u1)*width)));
+	int x1 = std::max(0, std::min(width-1, (int) floor(std::max(u0, u1)*width)));
+	int y0 = std::max(0, std::min(height-1, (int) floor(std::min(v0, v1)*height)));
+	int y1 = std::max(0, std::min(height-1, (int) floor(std::max(v0, v1)*height)));
+	int level = 0;
+	while (x1-x0 > 1 || y1-y0 > 1) {
+		x0 /= 2;
+		x1 /= 2;
+		y0 /= 2;
+		y1 /= 2;
+		level++;
+	}
+	vec2 r(FLT_MAX, -FLT_MAX);
+	for (int y = y0; y <= y1; y++)
+		for (int x = x0; x <= x1; x++) {
+			vec2 m = RangeAt(level, x, y);
+			r.x = std::min(r.x, m.x);
+			r.y = std::max(r.y, m.y);
+		}
+	return r;
+}
+
+// texture cache
+
+// textures are shared by contents: a file is hashed when first requested, and again only if its
+// size or modification time changes, so the same image under several names, or a file re-saved
+// unchanged, is decoded and uploaded once; GL textures are reference-counted, and decoded images
+// stay in a least-recently-used list (bounded in bytes) so a texture released and requested
+// again, as on a hot reload, is re-uploaded without decoding; not thread-safe, call from the GL thread
+
+struct FileHash {
+	unsigned long long size, hash;
+	long long time;
+};
+
+struct CachedImage {
+	unsigned long long hash;
+	char *pixels;
 	int width, height, bitsPerPixel;
-	char *pixels = ReadTexture(filename, width, height, bitsPerPixel);
-	if (!pixels) {
-		printf("No texture!\n");
-		return 0;
+	size_t Bytes() const { return (size_t) width*height*(bitsPerPixel/8); }
+};
+
+struct CachedTexture {
+	unsigned long long hash;
+	bool heightfield;
+	GLuint id;
+	int refCount;
+};
+
+static std::map<string, FileHash> fileHashes;
+static std::list<CachedImage> images;				// most recently used first
+static vector<CachedTexture> textures;
+static size_t imageBytes = 0, imageCacheSize = 64 << 20;
+
+void SetTextureCacheSize(size_t bytes) {
+	imageCacheSize = bytes;
+	while (!images.empty() && imageBytes > imageCacheSize) {
+		imageBytes -= images.back().Bytes();
+		delete [] images.back().pixels;
+		images.pop_back();
 	}
-	if (bitsPerPixel == 24) {
-		char *tmpPixels = new char[width*height];
-		// convert to luminance
-		for (int i = 0; i < width*height; i++) {
-			char *p = pixels+3*i;
-			tmpPixels[i] = (int) (.21*(double)p[2]+.72*(double)p[1]+.07*(double)p[0]);
+}
+
+static bool ContentHash(const char *filename, unsigned long long &hash) {
+	// 64-bit FNV-1a of the file, recomputed only if its size or time differ from the last call
+	FileHash stamp;
+	if (!FileStamp(filename, stamp.size, stamp.time))
+		return false;
+	std::map<string, FileHash>::iterator f = fileHashes.find(filename);
+	if (f != fileHashes.end() && f->second.size == stamp.size && f->second.time == stamp.time) {
+		hash = f->second.hash;
+		return true;
+	}
+	MappedFile in(filename);
+	if (!in.data)
+		return false;
+	const unsigned char *p = (const unsigned char *) in.data, *end = p+in.size;
+	for (stamp.hash = 14695981039346656037ULL; p < end; p++)
+		stamp.hash = (stamp.hash^*p)*1099511628211ULL;
+	fileHashes[filename] = stamp;
+	hash = stamp.hash;
+	return true;
+}
+
+static CachedImage *DecodedImage(const char *filename, unsigned long long hash) {
+	// return the image from the cache (moved to the front) or decode it; the image
+	// is valid until the next call, which may evict it
+	for (std::list<CachedImage>::iterator i = images.begin(); i != images.end(); i++)
+		if (i->hash == hash) {
+			images.splice(images.begin(), images, i);
+			return &images.front();
+		}
+	CachedImage image;
+	image.hash = hash;
+	if (!(image.pixels = ReadTexture(filename, image.width, image.height, image.bitsPerPixel)))
+		return NULL;
+	images.push_front(image);
+	imageBytes += image.Bytes();
+	// evict least recently used, but keep the new image even if it exceeds the cache size
+	while (images.size() > 1 && imageBytes > imageCacheSize) {
+		imageBytes -= images.back().Bytes();
+		delete [] images.back().pixels;
+		images.pop_back();
+	}
+	return &images.front();
+}
+
+static char *Luminance(const char *pixels, int width, int height, int bitsPerPixel) {
+	char *tmpPixels = new char[width*height];
+	BGRToLuminance((const unsigned char *) pixels, width*height, bitsPerPixel/8, (unsigned char *) tmpPixels);
+	return tmpPixels;
+}
+
+// texture baking
+
+// a texture may be baked to <source>.texbin (<source>.height.texbin for a heightfield): a header and
+// the full mip chain, level 0 first, rows bottom to top, so loading is one glTexImage2D (or
+// glCompressedTexImage2D) per level, without decoding or glGenerateMipmap; a heightfield is stored
+// as luminance; color levels are averaged in linear space (sRGB decoded, averaged, re-encoded);
+// levels are R8, BGR8, or BGRA8, or if compressed, BC4 (heightfield) or BC1 (color without alpha,
+// if the driver reads S3TC); a file is reused only if it has the format that would be baked now
+
+static bool useBakedTextures = false, compressBakedTextures = false;
+
+void UseBakedTextures(bool use, bool compress) {
+	useBakedTextures = use;
+	compressBakedTextures = compress;
+}
+
+static const float *SrgbTable() {
+	// linear value of each sRGB byte, then the 255 linear midpoints between successive bytes
+	static const vector<float> table = []() {
+		vector<float> t(511);
+		for (int i = 0; i < 256; i++) {
+			double c = i/255.;
+			t[i] = (float) (c <= .04045? c/12.92 : pow((c+.055)/1.055, 2.4));
+		}
+		for (int i = 0; i < 255; i++)
+			t[256+i] = .5f*(t[i]+t[i+1]);
+		return t;
+	}();
+	return &table[0];
+}
+
+static inline unsigned char LinearToSrgb(float v, const float *table) {
+	// nearest sRGB byte, by binary search of the midpoints
+	return (unsigned char) (std::upper_bound(table+256, table+511, v)-(table+256));
+}
+
+static char *HalveImage(const char *pixels, int &width, int &height, int bytesPerPixel, bool srgb) {
+	// return a new image half the size (rounding down, at least 1), each pixel the average of up to
+	// 2x2; if srgb, color channels (not alpha) are averaged in linear space
+	int w = width > 1? width/2 : 1, h = height > 1? height/2 : 1;
+	const float *table = srgb? SrgbTable() : NULL;
+	const unsigned char *src = (const unsigned char *) pixels;
+	unsigned char *dst = new unsigned char[(size_t) w*h*bytesPerPixel];
+	for (int j = 0; j < h; j++)
+		for (int i = 0; i < w; i++) {
+			int x0 = 2*i < width? 2*i : width-1, x1 = 2*i+1 < width? 2*i+1 : x0;
+			int y0 = 2*j < height? 2*j : height-1, y1 = 2*j+1 < height? 2*j+1 : y0;
+			const unsigned char *p00 = src+((size_t) y0*width+x0)*bytesPerPixel, *p01 = src+((size_t) y0*width+x1)*bytesPerPixel;
+			const unsigned char *p10 = src+((size_t) y1*width+x0)*bytesPerPixel, *p11 = src+((size_t) y1*width+x1)*bytesPerPixel;
+			unsigned char *d = dst+((size_t) j*w+i)*bytesPerPixel;
+			for (int k = 0; k < bytesPerPixel; k++)
+				d[k] = table && k < 3?
+					LinearToSrgb(.25f*(table[p00[k]]+table[p01[k]]+table[p10[k]]+table[p11[k]]), table) :
+					(unsigned char) ((p00[k]+p01[k]+p10[k]+p11[k]+2)/4);
 		}
+	width = w;
+	height = h;
+	return (char *) dst;
+}
+
+static void GetBlock(const unsigned char *pixels, int width, int height, int bytesPerPixel, int bx, int by, unsigned char block[16][3]) {
+	// copy 4x4 block at bx, by (first 1 or 3 bytes of each pixel), repeating the last row or column past an edge
+	for (int j = 0; j < 4; j++)
+		for (int i = 0; i < 4; i++) {
+			int x = bx+i < width? bx+i : width-1, y = by+j < height? by+j : height-1;
+			const unsigned char *p = pixels+((size_t) y*width+x)*bytesPerPixel;
+			for (int k = 0; k < 3 && k < bytesPerPixel; k++)
+				block[4*j+i][k] = p[k];
+		}
+}
+
+static void EncodeBC4(const unsigned char *pixels, int width, int height, unsigned char *out) {
+	// 8 bytes per 4x4 block: endpoints r0 > r1, then 16 3-bit indices into r0, r1, and six values between
+	unsigned char block[16][3];
+	for (int by = 0; by < height; by += 4)
+		for (int bx = 0; bx < width; bx += 4, out += 8) {
+			GetBlock(pixels, width, height, 1, bx, by, block);
+			int lo = 255, hi = 0;
+			for (int n = 0; n < 16; n++) {
+				lo = std::min(lo, (int) block[n][0]);
+				hi = std::max(hi, (int) block[n][0]);
+			}
+			unsigned long long bits = 0;
+			if (hi > lo)
+				for (int n = 0; n < 16; n++) {
+					// k of 7 steps from lo to hi; index 0 is hi, 1 is lo, 2-7 are 6/7 to 1/7 of the way
+					int k = ((block[n][0]-lo)*14+(hi-lo))/(2*(hi-lo));
+					bits |= (unsigned long long) (k == 7? 0 : k == 0? 1 : 8-k) << 3*n;
+				}
+			out[0] = (unsigned char) hi;
+			out[1] = (unsigned char) lo;
+			for (int b = 0; b < 6; b++)
+				out[2+b] = (unsigned char) (bits >> 8*b);
+		}
+}
+
+static int Pack565(const int c[3], int rgb[3]) {
+	// c is BGR; set rgb to the expanded 5-6-5 color
+	int r = (c[2]*31+127)/255, g = (c[1]*63+127)/255, b = (c[0]*31+127)/255;
+	rgb[0] = r << 3 | r >> 2;
+	rgb[1] = g << 2 | g >> 4;
+	rgb[2] = b << 3 | b >> 2;
+	return r << 11 | g << 5 | b;
+}
+
+static void EncodeBC1(const unsigned char *pixels, int width, int height, int bytesPerPixel, unsigned char *out) {
+	// 8 bytes per 4x4 block: 5-6-5 endpoints c0 > c1, then 16 2-bit indices into c0, c1, and the colors
+	// 1/3 and 2/3 of the way between; endpoints are the block's bounding box, inset by 1/16, along the
+	// diagonal that follows the correlation of each channel with the one of greatest range
+	unsigned char block[16][3];
+	for (int by = 0; by < height; by += 4)
+		for (int bx = 0; bx < width; bx += 4, out += 8) {
+			GetBlock(pixels, width, height, bytesPerPixel, bx, by, block);
+			int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0}, sum[3] = {0, 0, 0}, major = 0;
+			for (int n = 0; n < 16; n++)
+				for (int k = 0; k < 3; k++) {
+					lo[k] = std::min(lo[k], (int) block[n][k]);
+					hi[k] = std::max(hi[k], (int) block[n][k]);
+					sum[k] += block[n][k];
+				}
+			for (int k = 1; k < 3; k++)
+				if (hi[k]-lo[k] > hi[major]-lo[major])
+					major = k;
+			int c0[3], c1[3], rgb0[3], rgb1[3];
+			for (int k = 0; k < 3; k++) {
+				int covariance = 0, inset = (hi[k]-lo[k])/16;
+				for (int n = 0; n < 16; n++)
+					covariance += (16*block[n][k]-sum[k])*(16*block[n][major]-sum[major]);
+				c0[k] = hi[k]-inset;
+				c1[k] = lo[k]+inset;
+				if (covariance < 0)
+					std::swap(c0[k], c1[k]);
+			}
+			int q0 = Pack565(c0, rgb0), q1 = Pack565(c1, rgb1);
+			if (q0 < q1) {
+				std::swap(q0, q1);
+				std::swap(rgb0, rgb1);
+			}
+			unsigned int bits = 0;
+			if (q0 != q1) {
+				// with c0 > c1, the four colors are c0, c1, (2c0+c1)/3, (c0+2c1)/3
+				int palette[4][3];
+				for (int k = 0; k < 3; k++) {
+					palette[0][k] = rgb0[k];
+					palette[1][k] = rgb1[k];
+					palette[2][k] = (2*rgb0[k]+rgb1[k])/3;
+					palette[3][k] = (rgb0[k]+2*rgb1[k])/3;
+				}
+				for (int n = 0; n < 16; n++) {
+					int best = 0, bestD = INT_MAX;
+					for (int i = 0; i < 4; i++) {
+						int dr = palette[i][0]-block[n][2], dg = palette[i][1]-block[n][1], db = palette[i][2]-block[n][0];
+						int d = dr*dr+dg*dg+db*db;
+						if (d < bestD) {
+							bestD = d;
+							best = i;
+						}
+					}
+					bits |= (unsigned int) best << 2*n;
+				}
+			}
+			unsigned char bytes[8] = {(unsigned char) q0, (unsigned char) (q0 >> 8), (unsigned char) q1, (unsigned char) (q1 >> 8),
+									  (unsigned char) bits, (unsigned char) (bits >> 8), (unsigned char) (bits >> 16), (unsigned char) (bits >> 24)};
+			memcpy(out, bytes, 8);
+		}
+}
+
+enum BakedFormat {BF_R8 = 1, BF_BGR8, BF_BGRA8, BF_BC1, BF_BC4};
+
+struct BakedHeader {
+	char magic[8];
+	unsigned int version, format;
+	unsigned long long sourceSize;
+	long long sourceTime;
+	unsigned int width, height, nLevels, pad;
+	BakedHeader() : version(2), format(0), sourceSize(0), sourceTime(0), width(0), height(0), nLevels(0), pad(0) {
+		memcpy(magic, "TEXTURE", 8);
+	}
+};
+
+static size_t LevelBytes(int format, int width, int height) {
+	return format == BF_BC1 || format == BF_BC4? (size_t) ((width+3)/4)*((height+3)/4)*8 :
+		   (size_t) width*height*(format == BF_R8? 1 : format == BF_BGR8? 3 : 4);
+}
+
+static int MipLevels(int width, int height) {
+	// # levels, halving (rounding down) to 1x1
+	int nLevels = 1;
+	for (; width > 1 || height > 1; nLevels++) {
+		width = width > 1? width/2 : 1;
+		height = height > 1? height/2 : 1;
+	}
+	return nLevels;
+}
+
+static unsigned int BakedFormatFor(int bytesPerPixel, bool compress) {
+	// the format baked, and accepted on read, for an image of bytesPerPixel: BC4 or BC1 if compress,
+	// except BC1 needs S3TC support and there is no compressed format with alpha
+	return compress && bytesPerPixel == 1? BF_BC4 : compress && bytesPerPixel == 3 && GLEW_EXT_texture_compression_s3tc? BF_BC1 :
+		   bytesPerPixel == 1? BF_R8 : bytesPerPixel == 3? BF_BGR8 : BF_BGRA8;
+}
+
+static int BakedBytesPerPixel(int format) {
+	// bytes per pixel of the image a format was baked from
+	return format == BF_R8 || format == BF_BC4? 1 : format == BF_BGR8 || format == BF_BC1? 3 : 4;
+}
+
+static string BakedName(const char *filename, bool heightfield) {
+	return string(filename)+(heightfield? ".height.texbin" : ".texbin");
+}
+
+bool BakeTexture(const char *filename, bool heightfield, bool compress) {
+	BakedHeader h;
+	int width, height, bitsPerPixel;
+	if (!LittleEndian() || !FileStamp(filename, h.sourceSize, h.sourceTime))
+		return false;
+	char *pixels = ReadTexture(filename, width, height, bitsPerPixel);
+	if (!pixels)
+		return false;
+	if (heightfield && bitsPerPixel >= 24) {
+		char *l = Luminance(pixels, width, height, bitsPerPixel);
 		delete [] pixels;
-		pixels = tmpPixels;
+		pixels = l;
+		bitsPerPixel = 8;
+	}
+	int bytesPerPixel = bitsPerPixel/8;
+	h.format = BakedFormatFor(bytesPerPixel, compress);
+	h.width = width;
+	h.height = height;
+	h.nLevels = MipLevels(width, height);
+	string bakedName = BakedName(filename, heightfield);
+	FILE *out = fopen(bakedName.c_str(), "wb");
+	if (!out) {
+		delete [] pixels;
+		return false;
+	}
+	bool ok = fwrite(&h, sizeof(h), 1, out) == 1;
+	vector<unsigned char> block;
+	for (unsigned int level = 0; level < h.nLevels && ok; level++) {
+		if (level) {
+			char *half = HalveImage(pixels, width, height, bytesPerPixel, !heightfield);
+			delete [] pixels;
+			pixels = half;
+		}
+		size_t nBytes = LevelBytes(h.format, width, height);
+		const void *data = pixels;
+		if (h.format == BF_BC1 || h.format == BF_BC4) {
+			block.resize(nBytes);
+			if (h.format == BF_BC1)
+				EncodeBC1((unsigned char *) pixels, width, height, bytesPerPixel, &block[0]);
+			else
+				EncodeBC4((unsigned char *) pixels, width, height, &block[0]);
+			data = &block[0];
+		}
+		ok = fwrite(data, 1, nBytes, out) == nBytes;
 	}
-	// set and bind active texture corresponding with textureIds[1]
-	glActiveTexture(whichTexture == 1? GL_TEXTURE2 : GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, textureId);
-	// allocate GPU texture buffer; copy, free pixels
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // in case width not multiple of 4
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
 	delete [] pixels;
+	if (fclose(out) != 0 || !ok) {
+		remove(bakedName.c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool ReadBaked(const char *filename, bool heightfield) {
+	// upload each level of a current baked file to the bound texture; false if absent, stale, or malformed
+	BakedHeader h, expect;
+	if (!LittleEndian() || !FileStamp(filename, expect.sourceSize, expect.sourceTime))
+		return false;
+	MappedFile in(BakedName(filename, heightfield).c_str());
+	if (!in.data || in.size < sizeof(h))
+		return false;
+	memcpy(&h, in.data, sizeof(h));
+	bool compressed = h.format == BF_BC1 || h.format == BF_BC4;
+	if (memcmp(h.magic, expect.magic, sizeof(h.magic)) || h.version != expect.version || h.sourceSize != expect.sourceSize ||
+		h.sourceTime != expect.sourceTime ||
+		h.format != BakedFormatFor(BakedBytesPerPixel(h.format), compressBakedTextures) ||
+		!h.width || !h.height || h.nLevels > 32)
+		return false;
+	size_t total = sizeof(h);
+	for (unsigned int level = 0, w = h.width, ht = h.height; level < h.nLevels; level++, w = w > 1? w/2 : 1, ht = ht > 1? ht/2 : 1)
+		total += LevelBytes(h.format, w, ht);
+	if (in.size != total)
+		return false;
+	const char *p = in.data+sizeof(h);
+	GLenum formats[] = {0, GL_RED, GL_BGR, GL_BGRA, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RED_RGTC1};
+	GLint internalFormats[] = {0, GL_RED, GL_RGB, GL_RGBA};
+	for (unsigned int level = 0, w = h.width, ht = h.height; level < h.nLevels; level++, w = w > 1? w/2 : 1, ht = ht > 1? ht/2 : 1) {
+		size_t nBytes = LevelBytes(h.format, w, ht);
+		if (compressed)
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, formats[h.format], w, ht, 0, (GLsizei) nBytes, p);
+		else
+			glTexImage2D(GL_TEXTURE_2D, level, internalFormats[h.format], w, ht, 0, formats[h.format], GL_UNSIGNED_BYTE, p);
+		p += nBytes;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, h.nLevels-1);
+	return true;
+}
+
+static bool UploadBaked(const char *filename, bool heightfield) {
+	// upload from the baked file, (re)baking it if absent or stale
+	return useBakedTextures && (ReadBaked(filename, heightfield) ||
+		(BakeTexture(filename, heightfield, compressBakedTextures) && ReadBaked(filename, heightfield)));
+}
+
+static GLuint AcquireTexture(const char *filename, bool heightfield) {
+	unsigned long long hash;
+	if (!ContentHash(filename, hash)) {
+		printf("can't open %s\n", filename);
+		return 0;
+	}
+	for (size_t i = 0; i < textures.size(); i++)
+		if (textures[i].hash == hash && textures[i].heightfield == heightfield) {
+			textures[i].refCount++;
+			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			return textures[i].id;
+		}
+	CachedTexture t = {hash, heightfield, 0, 1};
+	glGenTextures(1, &t.id);
+	glBindTexture(GL_TEXTURE_2D, t.id);
+	// allocate GPU texture buffer; copy pixels
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);			// in case width not multiple of 4
+	if (heightfield && !HasExtension(filename, ".tga")) {
+		// 16-bit or float heights
+		HeightMap map;
+		if (!map.Read(filename)) {
+			glDeleteTextures(1, &t.id);
+			return 0;
+		}
+		UploadHeights(map);
+		textures.push_back(t);
+		return t.id;
+	}
+	if (UploadBaked(filename, heightfield)) {
+		textures.push_back(t);
+		return t.id;
+	}
+	CachedImage *image = DecodedImage(filename, hash);
+	if (!image) {
+		glDeleteTextures(1, &t.id);
+		return 0;
+	}
+	if (heightfield) {
+		char *pixels = image->bitsPerPixel >= 24? Luminance(image->pixels, image->width, image->height, image->bitsPerPixel) : image->pixels;
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, image->width, image->height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+		if (pixels != image->pixels)
+			delete [] pixels;
+	}
+	else {
+		GLint internalFormat = image->bitsPerPixel == 32? GL_RGBA : image->bitsPerPixel == 8? GL_RED : GL_RGB;
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image->width, image->height, 0, TextureFormat(image->bitsPerPixel), GL_UNSIGNED_BYTE, image->pixels);
+	}
 	glGenerateMipmap(GL_TEXTURE_2D);
+	textures.push_back(t);
+	return t.id;
+}
+
+GLuint AcquireTexture(const char *filename) {
+	return AcquireTexture(filename, false);
+}
+
+void ReleaseTexture(GLuint textureId) {
+	for (size_t i = 0; i < textures.size(); i++)
+		if (textures[i].id == textureId) {
+			if (--textures[i].refCount == 0) {
+				glDeleteTextures(1, &textureId);
+				textures.erase(textures.begin()+i);
+			}
+			return;
+		}
+}
+
+GLuint SetHeightfield(const char *filename, int whichTexture) {
+	// store as GL_TEXTURE1, or GL_TEXTURE2 if whichTexture is 1
+	GLSL::ActiveTexture(whichTexture == 1? GL_TEXTURE2 : GL_TEXTURE1);
+	GLuint textureId = AcquireTexture(filename, true);
+	if (!textureId)
+		printf("No texture!\n");
 	return textureId;
 }
+
+// texture streaming
+
+// uploads go through a ring of pixel-unpack buffers: a streamer holds a buffer from the time the worker
+// has sized the image (and Poll maps the buffer for the worker to decode into) until the fence after its
+// glTexImage2D has signaled; a buffer is allocated once and grown only for a larger image, and since
+// a free buffer's last upload has completed, it is mapped unsynchronized, without re-specifying it
+// the worker writes the whole mip chain into the buffer, so Poll uploads it without glGenerateMipmap
+
+struct PixelBuffer {
+	GLuint id;
+	GLsizeiptr size;
+	bool busy;
+};
+
+static PixelBuffer pixelRing[2] = {{0, 0, false}, {0, 0, false}};
+static int pixelNext = 0;
+
+static int AcquirePixelBuffer(GLsizeiptr nBytes) {
+	// return index of a free ring buffer of at least nBytes, or -1 if all are in use
+	for (int n = 0; n < 2; n++, pixelNext = (pixelNext+1)%2)
+		if (!pixelRing[pixelNext].busy) {
+			PixelBuffer &b = pixelRing[pixelNext];
+			if (!b.id)
+				glGenBuffers(1, &b.id);
+			if (b.size < nBytes) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, b.id);
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, nBytes, NULL, GL_STREAM_DRAW);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				b.size = nBytes;
+			}
+			b.busy = true;
+			return pixelNext;
+		}
+	return -1;
+}
+
+static size_t MipChainBytes(int width, int height, int bytesPerPixel) {
+	// # bytes of all levels, each following the last
+	size_t nBytes = (size_t) width*height*bytesPerPixel;
+	while (width > 1 || height > 1) {
+		width = width > 1? width/2 : 1;
+		height = height > 1? height/2 : 1;
+		nBytes += (size_t) width*height*bytesPerPixel;
+	}
+	return nBytes;
+}
+
+static void UploadLevels(GLuint textureId, int width, int height, int nLevels, int bytesPerPixel, GLint internalFormat, GLenum format, GLenum type) {
+	// from the bound pixel-unpack buffer, the mip chain as laid out by MipChainBytes
+	glBindTexture(GL_TEXTURE_2D, textureId);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	size_t offset = 0;
+	for (int level = 0; level < nLevels; level++) {
+		glTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, format, type, (void *) offset);
+		offset += (size_t) width*height*bytesPerPixel;
+		width = width > 1? width/2 : 1;
+		height = height > 1? height/2 : 1;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, nLevels-1);
+}
+
+char *TextureStreamer::MapRing(size_t n) {
+	// on the worker: have Poll map a ring buffer of n bytes; return it, or NULL if cancelled or unmappable
+	nBytes = n;
+	int decoding = Decoding;
+	if (!step.compare_exchange_strong(decoding, Sized))
+		return NULL;
+	while (step == Sized)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	return step == Filling? (char *) mapped : NULL;
+}
+
+void TextureStreamer::SetFormat(int bitsPerPixel) {
+	// on the worker, before Poll reads it (once previewReady or Filled)
+	bytesPerPixel = bitsPerPixel/8;
+	internalFormat = bitsPerPixel == 32? GL_RGBA : bitsPerPixel == 8? GL_RED : GL_RGB;
+	format = TextureFormat(bitsPerPixel);
+	type = GL_UNSIGNED_BYTE;
+}
+
+void TextureStreamer::PostPreview(char *pixels, int w, int h) {
+	// on the worker: hand Poll a new[] image to show until the full one is resident
+	preview = pixels;
+	previewWidth = w;
+	previewHeight = h;
+	previewReady = true;
+}
+
+bool TextureStreamer::Start(const char *filename, bool heightfield, int previewSize) {
+	Release();
+	unsigned long long size;
+	long long time;
+	if (!FileStamp(filename, size, time)) {
+		printf("can't open %s\n", filename);
+		return false;
+	}
+	step = Decoding;
+	previewReady = false;
+	string name(filename);
+	if (previewSize < 1)
+		previewSize = 1;
+	worker = std::thread([this, name, heightfield, previewSize]() {
+		// level 0 goes into the ring buffer, each smaller level after it, halved from the one before;
+		// the first level within previewSize is posted as the preview, unless one was posted sooner
+		if (heightfield && !HasExtension(name.c_str(), ".tga")) {
+			// 16-bit or float heights
+			HeightMap map;
+			if (!map.Read(name.c_str())) {
+				step = Failed;
+				return;
+			}
+			width = map.width;
+			height = map.height;
+			nLevels = MipLevels(width, height);
+			bytesPerPixel = map.bits == 32? 4 : 2;
+			internalFormat = map.bits == 32? GL_R32F : GL_R16;
+			format = GL_RED;
+			type = map.bits == 32? GL_FLOAT : GL_UNSIGNED_SHORT;
+			char *level = MapRing(MipChainBytes(width, height, bytesPerPixel));
+			if (!level) {
+				step = Failed;
+				return;
+			}
+			HeightPixels(map.heights, map.bits, level);
+			for (int w = width, h = height; w > 1 || h > 1; ) {
+				level += (size_t) w*h*bytesPerPixel;
+				HalveHeights(map.heights, w, h);
+				HeightPixels(map.heights, map.bits, level);
+				if (!previewReady && (width > previewSize || height > previewSize) && w <= previewSize && h <= previewSize)
+					PostPreview(HeightPixels(map.heights, map.bits), w, h);
+			}
+			step = Filled;
+			return;
+		}
+		// an uncompressed image is sampled for a preview before it is decoded
+		int bitsPerPixel, w, h;
+		char *sample = SampleTarga(name.c_str(), previewSize, w, h, bitsPerPixel);
+		if (sample) {
+			if (heightfield && bitsPerPixel >= 24) {
+				char *l = Luminance(sample, w, h, bitsPerPixel);
+				delete [] sample;
+				sample = l;
+				bitsPerPixel = 8;
+			}
+			SetFormat(bitsPerPixel);
+			PostPreview(sample, w, h);
+		}
+		// decode straight into the ring buffer, unless the image is to be converted to luminance
+		char *buffer = NULL, *color = NULL;
+		bool ok = DecodeTarga(name.c_str(), width, height, bitsPerPixel, [&](size_t n) {
+			return heightfield && bitsPerPixel >= 24? color = new char[n] : buffer = MapRing(MipChainBytes(width, height, bitsPerPixel/8));
+		});
+		if (ok && color) {
+			if ((buffer = MapRing(MipChainBytes(width, height, 1))) != NULL)
+				BGRToLuminance((const unsigned char *) color, width*height, bitsPerPixel/8, (unsigned char *) buffer);
+			bitsPerPixel = 8;
+		}
+		delete [] color;
+		if (!ok || !buffer) {
+			step = Failed;
+			return;
+		}
+		if (!sample)
+			SetFormat(bitsPerPixel);
+		nLevels = MipLevels(width, height);
+		int n = bitsPerPixel/8;
+		char *level = buffer;
+		for (w = width, h = height; w > 1 || h > 1; ) {
+			size_t levelBytes = (size_t) w*h*n;
+			char *half = HalveImage(level, w, h, n, !heightfield);
+			level += levelBytes;
+			memcpy(level, half, (size_t) w*h*n);
+			if (!previewReady && (width > previewSize || height > previewSize) && w <= previewSize && h <= previewSize)
+				PostPreview(half, w, h);
+			else
+				delete [] half;
+		}
+		step = Filled;
+	});
+	return true;
+}
+
+TextureStreamer::State TextureStreamer::Poll() {
+	int s = step;
+	if (s == Failed || s == Filled)
+		if (worker.joinable())
+			worker.join();
+	if (previewReady && preview) {
+		// show the preview, a single level
+		glGenTextures(1, &textureId);
+		glBindTexture(GL_TEXTURE_2D, textureId);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, previewWidth, previewHeight, 0, format, type, preview);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		delete [] preview;
+		preview = NULL;
+	}
+	if (s == Sized) {
+		// map a ring buffer for the worker to decode into; if none is free, try again next frame
+		if ((ring = AcquirePixelBuffer(nBytes)) >= 0) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelRing[ring].id);
+			mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, nBytes,
+									  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			if (!mapped) {
+				pixelRing[ring].busy = false;
+				ring = -1;
+				step = Failed;
+			}
+			else
+				step = Filling;
+		}
+	}
+	if (s == Filled) {
+		// upload the mip chain from the ring buffer (behind the preview, if any) and fence it
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelRing[ring].id);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		mapped = NULL;
+		GLuint &id = textureId? fullId : textureId;
+		glGenTextures(1, &id);
+		UploadLevels(id, width, height, nLevels, bytesPerPixel, internalFormat, format, type);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		step = Uploading;
+	}
+	if (s == Uploading) {
+		// once the upload has completed, replace the preview and free the ring buffer
+		GLenum r = glClientWaitSync(fence, 0, 0);
+		if (r == GL_ALREADY_SIGNALED || r == GL_CONDITION_SATISFIED) {
+			glDeleteSync(fence);
+			fence = NULL;
+			pixelRing[ring].busy = false;
+			ring = -1;
+			if (fullId) {
+				glDeleteTextures(1, &textureId);
+				textureId = fullId;
+				fullId = 0;
+			}
+			step = Resident;
+		}
+	}
+	s = step;
+	return s == Sized || s == Filling? Decoding : s == Filled? Uploading : (State) s;
+}
+
+void TextureStreamer::StopWorker() {
+	// a worker still decoding gives up at MapRing; wait for it
+	for (int s = step; (s == Decoding || s == Sized) && !step.compare_exchange_weak(s, Failed); )
+		;
+	if (worker.joinable())
+		worker.join();
+}
+
+void TextureStreamer::Release() {
+	StopWorker();
+	if (ring >= 0) {
+		if (mapped) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelRing[ring].id);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		// the next use maps the buffer unsynchronized, so its upload must be complete
+		if (fence)
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+				;
+		pixelRing[ring].busy = false;
+		ring = -1;
+	}
+	if (fence)
+		glDeleteSync(fence);
+	if (textureId)
+		glDeleteTextures(1, &textureId);
+	if (fullId)
+		glDeleteTextures(1, &fullId);
+	delete [] preview;
+	preview = NULL;
+	previewReady = false;
+	mapped = NULL;
+	fence = NULL;
+	textureId = fullId = 0;
+	step = Empty;
+}
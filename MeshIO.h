@@ -8,6 +8,8 @@
 #define MESH_HDR
 
 #include <vector>
+#include <atomic>
+#include <thread>
 #include "mat.h"
 
 using std::vector;
@@ -23,6 +25,10 @@ struct VertexSTL {
 int ReadSTL(char *filename, vector<VertexSTL> &vertices);
 	// return # triangles
 
+int ReadSTL(char *filename, vector<vec3> &points, vector<int3> &triangles, float tolerance = 0);
+	// read as an indexed mesh: vertices within tolerance (0: identical vertices) are welded
+	// into one point, and triangles collapsed by welding are dropped; return # triangles
+
 // OBJ format
 
 bool ReadAsciiObj(char          *filename,
@@ -30,23 +36,195 @@ bool ReadAsciiObj(char          *filename,
 				  vector<int3>	&triangles,
 				  vector<vec3>	*normals  = NULL,
 				  vector<vec2>	*textures = NULL,
-				  vector<int>	*triangleGroups = NULL);
+				  vector<int>	*triangleGroups = NULL,
+				  int			nThreads = 1);
 	// return true if successful
+	// if nThreads > 1 (0 for all hardware threads), large files are parsed in parallel
+
+// Binary Cache
+
+void UseMeshCache(bool use);
+	// ReadSTL and ReadAsciiObj save parsed arrays as <filename>.meshbin and reload
+	// them while <filename>'s size and time are unchanged (default false); a cache with
+	// indices out of range is ignored and the source parsed
+
+// Asynchronous Loading
+
+struct LoadMonitor {
+	std::atomic<float> fraction;				// of file parsed, 0 to 1
+	std::atomic<bool> cancel;					// set to stop loading
+	LoadMonitor() : fraction(0), cancel(false) { }
+};
+
+class MeshLoader {
+	// read an OBJ file (as ReadAsciiObj) on a worker thread so the GL thread keeps rendering
+public:
+	enum State {Empty, Loading, Loaded, Failed, Cancelled};
+	vector<vec3> points, normals;				// not to be touched until Poll returns Loaded
+	vector<int3> triangles;
+	vector<vec2> textures;
+	MeshLoader() : state(Empty) { }
+	~MeshLoader() { Cancel(); }
+	void Start(char *filename, bool readNormals = true, bool readTextures = false, int nThreads = 0);
+		// cancel any load in progress, clear the arrays, and begin reading filename
+	State Poll();
+		// call from the GL thread; once Loaded, the arrays may be uploaded
+	float Progress() { return monitor.fraction; }
+		// fraction of file read, 0 to 1
+	void Cancel();
+		// stop reading and wait for the worker thread
+private:
+	std::thread worker;
+	std::atomic<int> state;
+	LoadMonitor monitor;
+};
+
+// Streaming
+
+typedef bool (*TriangleBatch)(VertexSTL *vertices, int nTriangles, void *data);
+	// receives 3*nTriangles vertices, three per triangle, valid only during the call;
+	// return false to stop reading
+
+int StreamSTL(char *filename, TriangleBatch batch, void *data = NULL, int batchSize = 65536);
+int StreamAsciiObj(char *filename, TriangleBatch batch, void *data = NULL, int batchSize = 65536);
+	// read a mesh without building it in memory, calling batch for each batchSize triangles
+	// (the last batch may be smaller, an OBJ batch may exceed batchSize by one polygon);
+	// data is passed to batch; memory is one batch, plus the v and vn records for OBJ
+	// OBJ textures and groups are ignored; a corner without a normal gets its facet normal
+	// return # triangles read, or -1 if the file can't be read or is malformed
 
 // Normals
 
-void Normalize(vector<vec3> &points, float scale = 1);
+float Normalize(vector<vec3> &points, float scale = 1, vec3 *center = NULL, int nThreads = 1);
 
-void Normalize(vector<VertexSTL> &vertices, float scale = 1);
-	// translate and apply uniform scale so that vertices fit in -1,1 in X,Y and 0,1 in Z
+float Normalize(vector<VertexSTL> &vertices, float scale = 1, vec3 *center = NULL, int nThreads = 1);
+	// translate and apply uniform scale so that vertices fit in -scale,scale:
+	// each point p becomes s*(p-center); return s and, if non-null, set center
+	// if nThreads > 1 (0 for all hardware threads), large meshes are processed in parallel
 
-void SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals);
+void SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals, int nThreads = 1);
 	// compute/recompute vertex normals as the average of surrounding triangle normals
+	// if nThreads > 1 (0 for all hardware threads), large meshes are processed in parallel
+
+enum NormalWeight {NW_Uniform, NW_Area, NW_Angle};
+
+void SetVertexNormals(vector<vec3>	&points,
+					  vector<int3>	&triangles,
+					  vector<vec3>	&normals,
+					  NormalWeight	weight,
+					  float			creaseAngle = 180,
+					  vector<int>	*copiedFrom = NULL);
+	// as above, but weight each triangle normal equally, by triangle area, or by the triangle's angle
+	// at the vertex; where triangles meet at more than creaseAngle degrees, the vertex is split:
+	// copies are appended to points and triangles are re-indexed, so the mesh stays indexed;
+	// copiedFrom receives the original index of each appended point (to extend uvs, etc.)
 
 // Texture
 
 char *ReadTexture(const char *filename, int &width, int &height, int &bitsPerPixel);
+	// read .tga: true-color (15, 16, 24, 32 bit), grayscale, or color-mapped, uncompressed or RLE,
+	// any origin; return rows bottom to top (as glTexImage2D expects) with bitsPerPixel 8 (gray),
+	// 24 (BGR), or 32 (BGRA); caller deletes [] pixels; return NULL if unreadable
+
+GLenum TextureFormat(int bitsPerPixel);
+	// GL_RED, GL_BGR, or GL_BGRA, the glTexImage2D format of ReadTexture pixels
+
+void BGRToLuminance(const unsigned char *pixels, int nPixels, int bytesPerPixel, unsigned char *luminance);
+	// .21 red + .72 green + .07 blue of BGR (bytesPerPixel 3) or BGRA (4) pixels, rounded;
+	// luminance may be pixels, for conversion in place
+
+void SwapRedBlue(unsigned char *pixels, int nPixels, int bytesPerPixel);
+	// in place, BGR to RGB (bytesPerPixel 3) or BGRA to RGBA (4), or back
+
+void WidenTo16(const unsigned char *in, int n, unsigned short *out);
+	// 8-bit values to 16-bit, 0-255 to 0-65535
+
+GLuint AcquireTexture(const char *filename);
+	// return a mipmapped texture for filename, bound to the active texture unit; a file with the
+	// same contents as an earlier request shares its texture; return 0 if unreadable
+
+void ReleaseTexture(GLuint textureId);
+	// release a texture from AcquireTexture or SetHeightfield; it is deleted when no longer shared
+
+void SetTextureCacheSize(size_t bytes);
+	// bound the memory kept for decoded images, reused when a texture is acquired again (default 64MB)
+
+void UseBakedTextures(bool use, bool compress = false);
+	// if use, AcquireTexture and SetHeightfield load <source>.texbin (or .height.texbin): luminance
+	// for a heightfield and a precomputed mip chain; it is baked on first use and whenever the
+	// source's size or time changes; if compress, levels are BC4 (heightfield) or BC1 (color without
+	// alpha, if the driver supports S3TC; otherwise uncompressed);
+	// off by default: textures are decoded and kept in the decoded-image cache
+
+bool BakeTexture(const char *filename, bool heightfield = false, bool compress = false);
+	// write the baked file for filename, as for UseBakedTextures; return false if unreadable or unwritable
 
 GLuint SetHeightfield(const char *filename, int whichTexture = 0);
+	// as AcquireTexture, but a single-channel texture, bound to GL_TEXTURE1, or GL_TEXTURE2 if
+	// whichTexture is 1: luminance for .tga, else heights as read by HeightMap (R16 or R32F)
+
+class HeightMap {
+	// heights from .pgm (binary, 8 or 16-bit), .pfm (grayscale), .r32 (square, raw little-endian
+	// float), or otherwise .tga (luminance); integer heights are scaled to 0-1
+public:
+	int width, height, bits;					// bits is 8, 16, or 32 (float)
+	vector<float> heights;						// rows bottom to top
+	vector<vector<vec2> > ranges;				// min, max pyramid: ranges[k] is level k+1
+	HeightMap() : width(0), height(0), bits(0) { }
+	bool Read(const char *filename);
+		// return false if unreadable, unsupported, or truncated
+	GLuint Upload();
+		// create a mipmapped texture bound to the active texture unit: R16 for integer heights,
+		// R32F for float
+	void BuildRanges();
+		// level 0 is the heights; each texel of level k+1 is the min and max of the 2x2 below it,
+		// with (size+1)/2 texels on a side, down to 1x1
+	vec2 RangeAt(int level, int x, int y);
+		// min and max of pyramid texel x, y
+	vec2 Range(float u0, float v0, float u1, float v1);
+		// conservative min and max of the heights in a texture-coordinate rectangle, from at most
+		// four pyramid texels, for bounds and level-of-detail tests; builds the pyramid if needed
+};
+
+class TextureStreamer {
+	// read a .tga (or, for a heightfield, any HeightMap file) and build its mip chain on a worker thread,
+	// and upload it through a pixel buffer ring, so the GL thread doesn't stall on a large map; a
+	// reduced copy is shown until the image is resident: for an uncompressed .tga, sampled from the
+	// file as soon as the header is read, otherwise the first small enough level of the chain
+public:
+	enum State {Empty, Decoding, Uploading, Resident, Failed};
+	TextureStreamer() : step(Empty), previewReady(false), textureId(0), fullId(0), ring(-1), fence(NULL), mapped(NULL), preview(NULL) { }
+	~TextureStreamer() { Release(); }
+		// as Release, so destroy a streamer on the GL thread
+	bool Start(const char *filename, bool heightfield = false, int previewSize = 64);
+		// call from the GL thread; release any earlier texture and begin decoding filename
+		// (as for SetHeightfield if heightfield); preview is no larger than previewSize
+		// on a side; return false if the file can't be opened
+	State Poll();
+		// call from the GL thread each frame to advance the upload; may change the binding
+		// of the active texture unit, so bind Texture() after
+	GLuint Texture() { return textureId; }
+		// the preview until Resident, then the full image; 0 until a preview is ready
+	void Release();
+		// call from the GL thread; wait for the worker, free its ring buffer, and delete the textures
+private:
+	enum Step {Sized = Failed+1, Filling, Filled};
+	std::atomic<int> step;
+	std::atomic<bool> previewReady;
+	std::thread worker;
+	GLuint textureId, fullId;
+	int ring;
+	GLsync fence;
+	void *mapped;						// ring buffer, while the worker decodes into it
+	size_t nBytes;
+	char *preview;						// from the worker, uploaded by Poll once previewReady
+	int width, height, nLevels, bytesPerPixel, previewWidth, previewHeight;
+	GLint internalFormat;
+	GLenum format, type;
+	char *MapRing(size_t nBytes);
+	void SetFormat(int bitsPerPixel);
+	void PostPreview(char *pixels, int width, int height);
+	void StopWorker();
+};
 
 #endif
@@ -4,131 +4,7 @@
 #include "UI.h"
 #include "GLSL.h"
 
-// Misc
-
-vec2 ScreenPoint(vec3 &p, mat4 &m) {
-	vec4 xp = m*vec4(p, 1);
- 	return vec2(
-		((xp.x/xp.w)+1)*.5f*(float) glutGet(GLUT_WINDOW_WIDTH),
-		((xp.y/xp.w)+1)*.5f*(float) glutGet(GLUT_WINDOW_HEIGHT));
-}
-
-float ScreenDistSq(int x, int y, vec3 p, mat4 m) {
-	vec2 screen = ScreenPoint(p, m);
-	float dx = x-screen.x, dy = y-screen.y;
-    return dx*dx+dy*dy;
-}
-
-void ScreenLine(float xscreen, float yscreen, mat4 &modelview, mat4 &persp, float p1[], float p2[]) {
-    // compute 3D world space line, given by p1 and p2, that transforms
-    // to a line perpendicular to the screen at (xscreen, yscreen)
-	int vp[4];
-	double tpersp[4][4], tmodelview[4][4], a[3], b[3];
-	// get viewport
-	glGetIntegerv(GL_VIEWPORT, vp);
-	// create transposes
-	for (int i = 0; i < 4; i++)
-		for (int j = 0; j < 4; j++) {
-			tmodelview[i][j] = modelview[j][i];
-			tpersp[i][j] = persp[j][i];
-		}
-	if (gluUnProject(xscreen, yscreen, .25, (const double*) tmodelview, (const double*) tpersp, vp, &a[0], &a[1], &a[2]) == GL_FALSE)
-        printf("UnProject false\n");
-	if (gluUnProject(xscreen, yscreen, .50, (const double*) tmodelview, (const double*) tpersp, vp, &b[0], &b[1], &b[2]) == GL_FALSE)
-        printf("UnProject false\n");
-	for (int i = 0; i < 3; i++) {
-		p1[i] = (float) a[i];
-		p2[i] = (float) b[i];
-	}
-}
-
-mat4 ScreenMode() {
-	int width = glutGet(GLUT_WINDOW_WIDTH), height = glutGet(GLUT_WINDOW_HEIGHT);
-	mat4 scale = Scale(2.f / (float) width, 2.f / (float) height, 1.);
-	mat4 tran = Translate(-1, -1, 0);
-	return tran*scale;
-}
-
-bool IsVisible(vec3 &p, mat4 &fullview, vec2 *screenA) {
-	float winWidth = (float) glutGet(GLUT_WINDOW_WIDTH), winHeight = (float) glutGet(GLUT_WINDOW_HEIGHT);
-	vec4 xp = fullview*vec4(p, 1);
-	vec2 clip(xp.x/xp.w, xp.y/xp.w);	// clip space, +/1
-	vec2 screen(((float) winWidth/2.f)*(1.f+clip.x), ((float) winHeight/2.f)*(1.f+clip.y));
-	if (screenA)
-		*screenA = screen;
-	float z = xp.z/xp.w, zScreen;
-	glReadPixels((int)screen.x, (int)screen.y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &zScreen);
-	zScreen = 2*zScreen-1; // seems to work (clip range +/-1 but zbuffer range 0-1)
-	return z < zScreen;
-}
-
-// Text
-
-#define FormatString(buffer, maxBufferSize, format) {  \
-    if (format) {                                      \
-        va_list ap;                                    \
-        va_start(ap, format);                          \
-        _vsnprintf(buffer, maxBufferSize, format, ap); \
-        va_end(ap);                                    \
-    }                                                  \
-    else                                               \
-        (buffer)[0] = 0;                               \
-}
-
-void *font = GLUT_BITMAP_9_BY_15;
-
-void PutString(int x, int y, const char *text, vec3 &color) {
-	int program = GLSL::CurrentShader();
-	int w = glutGet(GLUT_WINDOW_WIDTH), h = glutGet(GLUT_WINDOW_HEIGHT);
-	glUseProgram(0); // no text support in GLSL
-	float xf = (float) (2*x)/w-1, yf = (float) (2*y)/h-1;
-	glColor3fv(&color.x);
-	glRasterPos2f(xf, yf);
-	glutBitmapString(font, (unsigned char*) text);
-	glUseProgram(program);
-}
-
-int Text(int x, int y, vec3 &color, char *format, ...) {
-    // place text at screen-space pixel (x, y)
-    char buf[500];
-    FormatString(buf, 500, format);
-    int ySpace = 12; // glmIsFontLarge()? 15 : 12;
-    const char *b = buf;
-    char line[500];
-    const char *endLine;
-    int nLine;
-    for (nLine = 0; *b; nLine++, b = endLine+1) {
-        int yy = y-ySpace*nLine;
-        while (*b == '\n')
-            b++;
-        if (!(endLine = strchr(b, '\n'))) {
-            PutString(x, yy, b, color);
-            break;
-        }
-        int nChars = endLine-b;
-        strncpy(line, b, nChars);
-        line[nChars] = 0;
-        PutString(x, yy, line, color);
-    }
-    return nLine+1;
-}
-
-void Text(vec3 &p, mat4 &m, int xoff, int yoff, vec3 &color, char *format, ...) {
-    char buf[500];
-	vec2 s = ScreenPoint(p, m);
-    FormatString(buf, 500, format);
-	Text((int) s.x+xoff, (int) s.y+yoff, color, buf);
-}
-
-void Text(vec3 &p, mat4 &m, char *text, vec3 &color) {
-	Text(p, m, 0, 0, color, text);
-}
-
-void Text(vec3 &p, mat4 &m, vec3 &color, char *format, ...) {
-    char buf[500];
-    FormatString(buf, 500, format);
-	Text(p, m, buf, color);
-}
+// screen operations, text, the draw list and the primitives it collects are in Draw.cpp
 
 // Keyboard
 
@@ -141,178 +17,24 @@ bool KeyDown(int c) { return (GetKeyState(c) & shortMSB) != 0; }
 
 // Draw
 
-static char *vertexShader = "\
-	#version 130								\n\
-	in vec3 point;								\n\
-    uniform mat4 view;							\n\
-	void main()									\n\
-	{											\n\
-		gl_Position = view*vec4(point, 1);		\n\
-	}											\n";
-
-static char *pixelShader = "\
-	#version 130								\n\
-	uniform float opacity = 1;					\n\
-	uniform vec3 color = vec3(1);				\n\
-	out vec4 pColor;							\n\
-	void main()									\n\
-	{											\n\
-	    pColor = vec4(color, opacity);			\n\
-	}											\n";
-
-GLuint drawShader = 0, drawBuffer = 0;
 static vec3 blk(0), wht(1), offWht(.95f), ltGry(.9f), mdGry(.6f), dkGry(.4f);
 
-void CheckDrawBuffer() {
-	if (!drawBuffer) {
-		glGenBuffers(1, &drawBuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
-		glBufferData(GL_ARRAY_BUFFER, 4*sizeof(vec3), NULL, GL_STATIC_DRAW);
-	}
+void Line(int x1, int y1, int x2, int y2, vec3 &color, float opacity, float width) {
+	vec3 p1((float) x1, (float) y1, 0), p2((float) x2, (float) y2, 0);
+	Line(p1, p2, color, opacity, width);
 }
 
-int UseDrawShader() {
-	int current = GLSL::CurrentShader();
-	if (!drawShader)
-		drawShader = InitShader(vertexShader, pixelShader);
-	if (current != drawShader)
-		glUseProgram(drawShader);
-	glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_LINE_SMOOTH);
-	glEnable(GL_POINT_SMOOTH);
-	return current;
-}
-
-int UseDrawShader(mat4 viewMatrix) {
-	int r = UseDrawShader();
-	GLSL::SetUniform(drawShader, "view", viewMatrix);
-	return r;
-}
-
-bool DashOn() {
-	GLboolean on = glIsEnabled(GL_LINE_STIPPLE);
-	glEnable(GL_LINE_STIPPLE);
-    glLineStipple(1, 3855); // on 4 bits / off 4 bits / on 4 bits / off 4 bits
-	return on != 0;
-}
-
-void DashOff() { glDisable(GL_LINE_STIPPLE); }
-
-// Disk
-
-void Disk(vec3 &point, float diameter, vec3 &color, float opacity) {
-	CheckDrawBuffer();
-	glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vec3), &point.x);
-	GLSL::VertexAttribPointer(drawShader, "point", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-	GLSL::SetUniform(drawShader, "opacity", opacity);
-	GLSL::SetUniform(drawShader, "color", color);
-	glPointSize(diameter);
-	glDrawArrays(GL_POINTS, 0, 1);
-}
-
-// Line
-
-void Line(vec3 &p1, vec3 &p2, vec3 &color, float opacity, float width, bool dashed) {
-	bool was = dashed? DashOn() : false;
-	dashed? DashOn() : void();
-	float w;
-	glGetFloatv(GL_LINE_WIDTH, &w);
-	glLineWidth(width);
-	int current = UseDrawShader();
-	CheckDrawBuffer();
-    glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vec3), &p1.x);
-    glBufferSubData(GL_ARRAY_BUFFER, sizeof(vec3), sizeof(vec3), &p2.x);
-	GLSL::VertexAttribPointer(drawShader, "point", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-	GLSL::SetUniform(drawShader, "color", color);
-	GLSL::SetUniform(drawShader, "opacity", opacity);
-	glDrawArrays(GL_LINES, 0, 2);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glUseProgram(current);
-	if (!was && dashed)
-		DashOff();
-	glLineWidth(w);
-}
-
-void Line(int x1, int y1, int x2, int y2, vec3 &color, float opacity) {
-	Line(vec3((float) x1, (float) y1, 0), vec3((float) x2, (float) y2, 0), color, opacity);
-}
-
-// Misc
-
 void Line(float x1, float y1, float x2, float y2, vec3 &color, float opacity) {
-	Line(vec3(x1, y1, 0), vec3(x2, y2, 0), color, opacity);
-}
-
-vec2 UnitPoint(float radians) { return vec2(cos(radians), sin(radians)); }
-
-void Circle(vec2 &p, float radius, vec3 &color) {
-	vec2 p1 = p+radius*UnitPoint(11.f/12.f);
-    for (int i = 0; i < 12; i++) {
-		float a1 = (float) i / 12, a2 = (float) (i+1) / 12;
-		vec2 p1 = p+radius*UnitPoint(2*3.1415f*a1);
-		vec2 p2 = p+radius*UnitPoint(2*3.1415f*a2);
-		Line(p1.x, p1.y, p2.x, p2.y, color);
-		p1 = p2;
-    }
-}
-
-void Crosshairs(vec2 &s, float radius, vec3 &color) {
-    float innerRad = .4f*radius;
-	Circle(s, .5f, color);
-    Circle(s, 2*innerRad, color);
-    Line(s.x-innerRad, s.y, s.x-radius, s.y, color);
-    Line(s.x+innerRad, s.y, s.x+radius, s.y, color);
-    Line(s.x, s.y-innerRad, s.x, s.y-radius, color);
-    Line(s.x, s.y+innerRad, s.x, s.y+radius, color);
-}
-
-void Sun(vec2 &p, vec3 *flashColor) {
-	vec3 c(p.x, p.y, 0);
-	vec3 yel(1, 1, 0), red(1, 0, 0), *col = flashColor? flashColor : &red;
-	// wish small yellow on larger red disk regardless of z-buffer
-    Disk(c, 8, yel);
-    Disk(c, 12, *col);
-    Disk(c, 8, yel);
-	glLineWidth(1.);
-    for (int r = 0, nRays = 16; r < nRays; r++) {
-        float a = 2*3.141592f*(float)r/(nRays-1), dx = cos(a), dy = sin(a);
-        float len = 11*(r%2? 1.8f : 2.5f);
-        Line(vec3(p.x+9*dx, p.y+9*dy, 0), vec3(p.x+len*dx, p.y+len*dy, 0), *col);
-    }
+	vec3 p1(x1, y1, 0), p2(x2, y2, 0);
+	Line(p1, p2, color, opacity);
 }
 
-// Quad
-
 void Quad(vec3 &p1, vec3 &p2, vec3 &p3, vec3 &p4, vec3 &color, float opacity) {
-	int current = UseDrawShader();
-	vec3 points[] = {p1, p2, p3, p4};
-	CheckDrawBuffer();
-    glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, 4*sizeof(vec3), points);
-	GLSL::VertexAttribPointer(drawShader, "point", 3, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-	GLSL::SetUniform(drawShader, "color", color);
-	GLSL::SetUniform(drawShader, "opacity", opacity);
-	glDrawArrays(GL_QUADS, 0, 4);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glUseProgram(current);
+	Quad(p1, p2, p3, p4, &color.x, opacity);
 }
 
 void Rectangle(int x, int y, int w, int h, vec3 &color, bool solid, float opacity) {
-	float x1 = (float) x, x2 = (float) (x+w), y1 = (float) y, y2 = (float) (y+h);
-	if (solid)
-		Quad(vec3(x1, y1, 0), vec3(x2, y1, 0), vec3(x2, y2, 0), vec3(x1, y2, 0), color, opacity);
-	else {
-		float linewidth;
-		glGetFloatv(GL_LINE_WIDTH, &linewidth);
-		float halfw = .5f*linewidth;
-		Line(vec3(x1-halfw, y1, 0), vec3(x2+halfw, y1, 0), color, opacity);
-		Line(vec3(x2, y1-halfw, 0), vec3(x2, y2+halfw, 0), color, opacity);
-		Line(vec3(x1-halfw, y2, 0), vec3(x2+halfw, y2, 0), color, opacity);
-		Line(vec3(x1, y1-halfw, 0), vec3(x1, y2+halfw, 0), color, opacity);
-	}
+	Rectangle(x, y, w, h, &color.x, solid, opacity);
 }
 
 // Buttons
@@ -418,14 +140,15 @@ void Button::ShowName(char *name, vec3 &col) {
 void Button::Draw(vec3 *statusColor) { Draw(NULL, statusColor); }
 
 void Button::Draw(char *nameOverride, vec3 *statusColor) {
+	BeginDrawList();
 	if (winW < 0) {
 		winW = glutGet(GLUT_WINDOW_WIDTH);
 		winH = glutGet(GLUT_WINDOW_HEIGHT);
 	}
-	glDisable(GL_BLEND);
-	glDisable(GL_LINE_SMOOTH);
-	glDisable(GL_POINT_SMOOTH);
-	glDisable(GL_DEPTH_TEST);
+	GLSL::Disable(GL_BLEND);
+	GLSL::Disable(GL_LINE_SMOOTH);
+	GLSL::Disable(GL_POINT_SMOOTH);
+	GLSL::Disable(GL_DEPTH_TEST);
 	if (type == B_Rectangle) {
 		float c[] = {1,0,0};
 		Rectangle(x, y, w, h, offWht, true);
@@ -459,14 +182,17 @@ void Button::Draw(char *nameOverride, vec3 *statusColor) {
 		}
 	}
 	ShowName(nameOverride? nameOverride : (char *) name.c_str(), textColor);
+	EndDrawList();
 }
 
 void Button::Highlight() {
+	BeginDrawList();
 	Rectangle(x, y, w, h, wht, true, .5f);
-	glLineWidth(1.f);
+	GLSL::LineWidth(1.f);
 	float x1 = (float)x, x2 = x1+(float)w, y1 = (float)y, y2 = y1+(float)h;
 	Line(vec3(x1+1, y1+1.5f, 0), vec3(x2-1, y1+1.5f, 0), blk, 1);
 	Line(vec3(x2-1.5f, y2-1, 0), vec3(x2-1.5f, y1+1, 0), blk, 1);
+	EndDrawList();
 }
 
 bool Button::Hit(int ax, int ay) {
@@ -530,8 +256,9 @@ void Slider::SetRange(float min, float max, float init) {
 }	
 
 void Slider::Draw(char *nameOverride, vec3 *sliderColor) {
+	BeginDrawList();
 	//vec3 *sCol = sliderColor? sliderColor : &color;
-	//glLineWidth(2);
+	//GLSL::LineWidth(2);
 	int iloc = (int) loc;
 	float grays[] = {160, 105, 227, 255};
 	if (vertical) {
@@ -591,6 +318,7 @@ void Slider::Draw(char *nameOverride, vec3 *sliderColor) {
 			PutString(x+1-wBuf/2, y-15, start, col);
 		}
 	}
+	EndDrawList();
 }
 
 float Slider::GetValue() {
@@ -5,39 +5,12 @@
 #define UI_HDR
 
 #include <string>
-#include "mat.h"
+#include "Draw.h"
 
 using std::string;
 
-// Screen
-
-vec2 ScreenPoint(vec3 &p, mat4 &m);
-	// return 2D screen location of p
-
-float ScreenDistSq(int x, int y, vec3 p, mat4 m);
-	// return distance in pixels between 2D screen point (x, y) and transformed p
-
-void ScreenLine(float xscreen, float yscreen, mat4 &modelview, mat4 &persp, float p1[], float p2[]);
-    // compute 3D world space line, given by p1 and p2, that transforms
-    // to a line perpendicular to the screen at pixel (xscreen, yscreen)
-
-mat4 ScreenMode();
-	// matrix to transform to pixel space
-
-bool IsVisible(vec3 &p, mat4 &view, vec2 *screen = NULL);
-	// if the depth test is enabled, is point p visible?
-	// if non-null, set screen location (in pixels) of transformed p
-	// view should include modelView and persp/ortho
-
-// Text
-
-int Text(int x, int y, vec3 &color, char *format, ...);
-
-void Text(vec3 &p, mat4 &m, int xoff, int yoff, vec3 &color, char *format, ...);
-
-void Text(vec3 &p, mat4 &m, char *text, vec3 &color);
-
-void Text(vec3 &p, mat4 &m, vec3 &color, char *format, ...);
+// screen operations, text, the draw list, disks, lines, instanced disks and spheres, and
+// VisibilityQuery are declared in Draw.h (and defined in Draw.cpp, which UI programs link)
 
 // Keyboard
 
@@ -48,18 +21,7 @@ bool KeyDown(int c);
 	// is the key presently down?
 
 // Drawing
-
-int UseDrawShader();
-
-int UseDrawShader(mat4 viewMatrix);
-
-bool DashOn();
-
-void DashOff();
-
-void Disk(vec3 &point, float diameter, vec3 &color, float opacity = 1);
-
-void Line(vec3 &p1, vec3 &p2, vec3 &color, float opacity = 1, float width = 1, bool dashed = false);
+//     as the Draw.h routines, with a single vec3 color
 
 void Line(int x1, int y1, int x2, int y2, vec3 &color, float opacity = 1, float width = 1);
 
@@ -69,13 +31,6 @@ void Quad(vec3 &pnt1, vec3 &pnt2, vec3 &pnt3, vec3 &pnt4, vec3 &color, float opa
 
 void Rectangle(int x, int y, int w, int h, vec3 &color, bool solid = true, float opacity = 1);
 
-void Circle(vec2 &p, float radius, vec3 &color);
-
-void Crosshairs(vec2 &s, float radius, vec3 &color);
-
-void Sun(vec2 &s, vec3 *flashColor = NULL);
-	// draw a sun at pixel s, with optionally colored sun-rays
-
 // Pushbutton and Checkbox
 
 class Button {
@@ -2,6 +2,7 @@
 // copyright (c) Jules Bloomenthal, 2012-2016, all rights reserved
 
 #include "Draw.h"
+#include "GLSL.h"
 #include "Widget.h"
 #include <gl/freeglut.h>
 
@@ -232,11 +233,11 @@ void Button::Draw(char *nameOverride, float *statusColor) {
 		winW = glutGet(GLUT_WINDOW_WIDTH);
 		winH = glutGet(GLUT_WINDOW_HEIGHT);
 	}
-	glDisable(GL_BLEND);
-	glDisable(GL_LINE_SMOOTH);
-	glDisable(GL_POINT_SMOOTH);
+	GLSL::Disable(GL_BLEND);
+	GLSL::Disable(GL_LINE_SMOOTH);
+	GLSL::Disable(GL_POINT_SMOOTH);
 //	glDisable(GL_DEPTH_BUFFER);
-	glDisable(GL_DEPTH_TEST);
+	GLSL::Disable(GL_DEPTH_TEST);
 	if (type == B_Rectangle) {
 		float c[] = {1,0,0};
 		Rectangle(x, y, w, h, offWht, true);
@@ -275,7 +276,7 @@ void Button::Draw(char *nameOverride, float *statusColor) {
 
 void Button::Highlight() {
 	Rectangle(x, y, w, h, wht, true, .5f);
-	glLineWidth(1.f);
+	GLSL::LineWidth(1.f);
 	float x1 = (float)x, x2 = x1+(float)w, y1 = (float)y, y2 = y1+(float)h;
 	Line(x1+1, y1+1.5f, x2-1, y1+1.5f, blk, blk, 1);
 	Line(x2-1.5f, y2-1, x2-1.5f, y1+1, blk, blk, 1);
@@ -343,7 +344,7 @@ void Slider::SetRange(float min, float max, float init) {
 
 void Slider::Draw(char *nameOverride, float *sliderColor) {
 	float *sCol = sliderColor? sliderColor : color;
-	glLineWidth(2);
+	GLSL::LineWidth(2);
 	int iloc = (int) loc;
 	float grays[] = {160, 105, 227, 255};
 	if (orientation == Hor) {